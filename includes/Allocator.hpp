@@ -0,0 +1,99 @@
+#ifndef VK_ALLOCATOR_HPP_
+#define VK_ALLOCATOR_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <PhysicalDevice.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace basicvk {
+	struct MemoryBlock;
+
+	//linear resources (buffers, linear images) and optimal images never share a block,
+	//so sub-allocations don't have to be padded to bufferImageGranularity
+	enum class MemoryResourceType {
+		Linear,
+		Optimal
+	};
+
+	enum class MemoryUsage {
+		Dynamic,	//written by the cpu, read by the gpu every frame: host visible, device local when the heap allows it
+		GpuOnly,	//device local, filled through copies
+		Upload,		//staging memory, host visible and coherent
+		Readback	//host visible and cached, read back by the cpu
+	};
+
+	struct MemoryAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		MemoryBlock* block = nullptr;
+		void* mappedData = nullptr;	//set for host visible memory, which stays mapped for the whole block lifetime
+	};
+
+	struct MemoryBlockStats {
+		uint32_t memoryTypeIndex;
+		VkDeviceSize size;
+		VkDeviceSize usedBytes;
+		uint32_t allocationCount;
+		uint32_t freeRangeCount;
+		VkDeviceSize largestFreeRange;
+		bool dedicated;
+	};
+
+	struct MemoryStats {
+		uint32_t blockCount;
+		uint32_t dedicatedBlockCount;
+		uint32_t allocationCount;
+		VkDeviceSize reservedBytes;
+		VkDeviceSize usedBytes;
+		uint32_t freeRangeCount;
+		VkDeviceSize largestFreeRange;
+		float fragmentation;	//0 when all the free memory is contiguous, close to 1 when it is scattered
+		std::vector<MemoryBlockStats> blocks;
+	};
+
+	class MemoryAllocator {
+	public:
+		//bufferDeviceAddress allocates linear blocks so that buffers bound to them can be used with vkGetBufferDeviceAddress
+		MemoryAllocator(VkDevice device, std::shared_ptr<PhysicalDevice> physicalDevicePtr, bool bufferDeviceAddress = false,
+			VkDeviceSize preferredBlockSize = 64ull * 1024 * 1024);
+		~MemoryAllocator();
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator(MemoryAllocator&&) = delete;
+		MemoryAllocator operator=(const MemoryAllocator&) = delete;
+		MemoryAllocator operator=(MemoryAllocator&&) = delete;
+
+		MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryResourceType resourceType);
+		MemoryAllocation allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryResourceType resourceType);
+		void free(MemoryAllocation& allocation);
+		bool isHostCoherent(const MemoryAllocation& allocation) const;
+		void flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+		void flushMappedRanges();
+		void invalidate(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+		uint32_t findMemoryType(uint32_t typeFilter, MemoryUsage usage) const;
+
+		MemoryStats getStats() const;
+
+	private:
+		MemoryAllocation allocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, MemoryResourceType resourceType);
+		MemoryBlock* createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, MemoryResourceType resourceType, bool dedicated);
+		void destroyBlock(MemoryBlock* block);
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+		VkMappedMemoryRange getMappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+		VkDevice device;
+		std::shared_ptr<PhysicalDevice> physicalDevice;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize nonCoherentAtomSize;
+		VkDeviceSize preferredBlockSize;
+		bool bufferDeviceAddress;
+		std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		std::vector<VkMappedMemoryRange> pendingFlushes;
+		mutable std::mutex mutex;
+	};
+}
+
+#endif // !VK_ALLOCATOR_HPP_
@@ -0,0 +1,87 @@
+#ifndef VK_ASSET_PACK_HPP_
+#define VK_ASSET_PACK_HPP_
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace basicvk {
+	//on disk layout written by the AssetCooker tool, every offset is absolute in the file and 16 bytes aligned
+	//so regions can be copied from the mapping to staging memory as they are
+	const uint32_t ASSET_PACK_MAGIC = 0x4B504B56;	//"VKPK"
+	const uint32_t ASSET_PACK_VERSION = 1;
+	const uint32_t ASSET_PACK_MAX_LEVELS = 16;
+	const uint32_t ASSET_PACK_NAME_SIZE = 64;
+
+	enum class AssetType : uint32_t {
+		Texture = 0,
+		Mesh = 1
+	};
+
+	struct AssetPackHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+		uint64_t entryOffset;
+	};
+
+	struct AssetPackRegion {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	//vertex layout of cooked meshes, indices are always uint32
+	struct PackedVertex {
+		float position[3];
+		float normal[3];
+		float texCoord[2];
+	};
+
+	struct AssetPackEntry {
+		char name[ASSET_PACK_NAME_SIZE];
+		AssetType type;
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		AssetPackRegion vertices;
+		AssetPackRegion indices;
+		AssetPackRegion levels[ASSET_PACK_MAX_LEVELS];
+	};
+
+	//read only memory mapping of a cooked pack, the index is validated once at open
+	class AssetPack {
+	public:
+		AssetPack(const std::string& path);
+		~AssetPack();
+		AssetPack(const AssetPack&) = delete;
+		AssetPack(AssetPack&&) = delete;
+		AssetPack operator=(const AssetPack&) = delete;
+		AssetPack operator=(AssetPack&&) = delete;
+
+		const AssetPackEntry* find(const std::string& name) const;
+		const AssetPackEntry& getEntry(const std::string& name) const;
+		uint32_t getEntryCount() const;
+		const AssetPackEntry& getEntry(uint32_t index) const;
+		const char* getData(const AssetPackRegion& region) const;
+
+	private:
+		void unmap();
+		void validateRegion(const AssetPackRegion& region) const;
+
+		const char* mappedData;
+		uint64_t mappedSize;
+		void* fileHandle;
+		void* mappingHandle;
+		const AssetPackEntry* entries;
+		uint32_t entryCount;
+		std::unordered_map<std::string, uint32_t> entryIndices;
+	};
+}
+
+#endif // !VK_ASSET_PACK_HPP_
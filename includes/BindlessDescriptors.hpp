@@ -0,0 +1,87 @@
+#ifndef VK_BINDLESS_DESCRIPTORS_HPP_
+#define VK_BINDLESS_DESCRIPTORS_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Descriptors.hpp>
+#include <Synchronous.hpp>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace basicvk {
+	//counts are clamped to the update after bind limits of the device
+	struct BindlessDescriptorsOptions {
+		uint32_t maxSampledImages = 16384;
+		uint32_t maxSamplers = 256;
+		uint32_t maxStorageBuffers = 16384;
+		VkShaderStageFlags shaderStages = VK_SHADER_STAGE_ALL;
+		std::shared_ptr<QueueTimeline> timeline;	//the queue of the submissions indexing the set, removal tickets refer to it
+	};
+
+	//one update after bind set shared by every draw, resources are addressed by index from the shaders:
+	//binding 0 texture2D[], binding 1 sampler[], binding 2 storage buffers[].
+	//slots can be written while the set is bound, a removed index is only reused once the submissions using it completed.
+	//needs DeviceFeatures::descriptorIndexing
+	class BindlessDescriptors {
+	public:
+		static const uint32_t SAMPLED_IMAGE_BINDING = 0;
+		static const uint32_t SAMPLER_BINDING = 1;
+		static const uint32_t STORAGE_BUFFER_BINDING = 2;
+
+		BindlessDescriptors(std::shared_ptr<Device> device, BindlessDescriptorsOptions options);
+		BindlessDescriptors(const BindlessDescriptors&) = delete;
+		BindlessDescriptors(BindlessDescriptors&&) = delete;
+		BindlessDescriptors operator=(const BindlessDescriptors&) = delete;
+		BindlessDescriptors operator=(BindlessDescriptors&&) = delete;
+
+		//the texture must be in SHADER_READ_ONLY_OPTIMAL when sampled
+		uint32_t addTexture(const Texture& texture);
+		//an index written later with writeTexture, the slot stays unbound until then
+		uint32_t reserveTexture();
+		void writeTexture(uint32_t index, const Texture& texture);
+		//ticket of the last submission on the timeline that may index the slot, 0 when none did
+		void removeTexture(uint32_t index, uint64_t ticket);
+		//samplers are deduplicated, they stay in the set as long as it lives
+		uint32_t addSampler(VkSampler sampler);
+		uint32_t addBuffer(const Buffer& buffer, uint64_t offset = 0, uint64_t range = VK_WHOLE_SIZE);
+		void removeBuffer(uint32_t index, uint64_t ticket);
+
+		const DescriptorSetLayout& getDescriptorSetLayout() const;
+		std::shared_ptr<DescriptorSet> getDescriptorSet() const;
+
+	private:
+		struct PendingIndex {
+			uint32_t index;
+			uint64_t ticket;
+		};
+
+		//indices handed out in order, removed ones are recycled first once their ticket completed
+		struct IndexAllocator {
+			uint32_t capacity;
+			uint32_t next;
+			std::vector<uint32_t> freed;
+			std::vector<PendingIndex> pending;
+
+			uint32_t allocate(const QueueTimeline& timeline);
+			void free(uint32_t index, uint64_t ticket);
+		};
+
+		static BindlessDescriptorsOptions clampToLimits(std::shared_ptr<Device> device, BindlessDescriptorsOptions options);
+
+		std::shared_ptr<Device> device_ptr;
+		BindlessDescriptorsOptions options;
+		DescriptorSetLayout descriptorSetLayout;
+		DescriptorPool descriptorPool;
+		std::shared_ptr<DescriptorSet> descriptorSet;
+		std::mutex mutex;
+		IndexAllocator images;
+		IndexAllocator samplers;
+		IndexAllocator buffers;
+		std::unordered_map<VkSampler, uint32_t> samplerIndices;
+	};
+}
+
+#endif // !VK_BINDLESS_DESCRIPTORS_HPP_
@@ -3,12 +3,27 @@
 
 #include <vulkan/vulkan.hpp>
 #include <Device.hpp>
+#include <ResourceState.hpp>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 namespace basicvk {
+	template<typename T>
+	struct MappedSpan {
+		T* data;
+		size_t count;
+
+		T* begin() const { return data; }
+		T* end() const { return data + count; }
+		T& operator[](size_t index) const { return data[index]; }
+		size_t size() const { return count; }
+	};
+
 	struct BufferOptions {
 		VkBufferUsageFlags usage;
 		VkSharingMode sharingMode;
+		MemoryUsage memoryUsage = MemoryUsage::Dynamic;
 	};
 
 	class Buffer {
@@ -23,13 +38,37 @@ namespace basicvk {
 		VkBuffer getVkBuffer() const;
 		uint64_t getBufferSize() const;
 		VkDeviceMemory getBufferMemory() const;
+		VkDeviceSize getMemoryOffset() const;
+		void* getMappedData() const;
+		//needs SHADER_DEVICE_ADDRESS_BIT usage and DeviceFeatures::bufferDeviceAddress
+		VkDeviceAddress getDeviceAddress() const;
+		//last access recorded through CommandBuffer::requireAccess
+		ResourceState& getResourceState() const;
 
 		void mapMemory(void* data, uint64_t size);
+		void write(const void* data, uint64_t size, uint64_t offset = 0);
+		void flush(uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE);
+		void invalidate(uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE);
+
+		//typed view over the persistent mapping, writes through it must be followed by flush() on non coherent memory
+		template<typename T>
+		MappedSpan<T> getMappedSpan(uint64_t offset = 0, uint64_t count = UINT64_MAX) const
+		{
+			if (allocation.mappedData == nullptr) {
+				throw std::runtime_error("buffer memory is not host visible");
+			}
+			if (offset > bufferSize) {
+				throw std::out_of_range("mapped span offset is past the end of the buffer");
+			}
+			uint64_t available = (bufferSize - offset) / sizeof(T);
+			return { reinterpret_cast<T*>(static_cast<char*>(allocation.mappedData) + offset), static_cast<size_t>(count < available ? count : available) };
+		}
 
 	private:
 		VkBuffer buffer;
-		VkDeviceMemory bufferMemory;
+		MemoryAllocation allocation;
 		uint64_t bufferSize;
+		mutable ResourceState resourceState;	//synchronization bookkeeping, not part of the buffer contents
 		std::shared_ptr<Device> device_ptr;
 	};
 
@@ -42,11 +81,17 @@ namespace basicvk {
 		VkImageUsageFlags usage;
 		VkMemoryPropertyFlags properties;
 		bool useMimaping;
+		uint32_t mipLevels = 0;	//explicit level count for pre-baked mip chains, 0 derives it from useMimaping
+		VkImageCreateFlags flags = 0;
+		SamplerDescription sampler{};
+		const MemoryAllocation* aliasedMemory = nullptr;	//bound into memory owned by the caller instead of allocating, see getMemoryRequirements
 	};
 
 	class Texture {
 	public:
 		Texture(std::shared_ptr<Device> devicePtr, TextureOptions options);
+		//what the image of these options needs, for memory aliased between several textures
+		static VkMemoryRequirements getMemoryRequirements(std::shared_ptr<Device> devicePtr, const TextureOptions& options);
 		~Texture();
 		Texture(Texture& texture);
 		Texture operator=(Texture& other);
@@ -55,6 +100,7 @@ namespace basicvk {
 
 		VkImage getVkImage() const;
 		VkDeviceMemory getVkImageMemory() const;
+		VkDeviceSize getMemoryOffset() const;
 		VkImageView getVkImageView() const;
 		VkSampler getVkSampler() const;
 		uint32_t getWidth() const;
@@ -62,15 +108,17 @@ namespace basicvk {
 		uint32_t getMipLevels() const;
 		VkFormat getVkFormat() const;
 		VkImageLayout getVkImageLayout() const;
+		//for barriers recorded by hand, every level is then assumed written by any stage
 		void setVkImageLayout(VkImageLayout imageLayout);
+		ResourceState& getResourceState(uint32_t mipLevel);
 
 	private:
 		VkImage image;
-		VkDeviceMemory imageMemory;
+		MemoryAllocation allocation;
 		VkImageView imageView;
 		VkSampler sampler;
 		VkFormat format;
-		VkImageLayout imageLayout;
+		std::vector<ResourceState> subresourceStates;	//one per mip level
 		uint32_t width;
 		uint32_t height;
 		uint32_t mipLevels;
@@ -3,20 +3,68 @@
 
 #include <vulkan/vulkan.hpp>
 #include <Device.hpp>
+#include <array>
 #include <memory>
 #include <Buffer.hpp>
 #include <Swapchain.hpp>
 #include <Framebuffer.hpp>
 #include <Synchronous.hpp>
+#include <ComputePipeline.hpp>
+#include <ResourceState.hpp>
+#include <type_traits>
+#include <vector>
 
 namespace basicvk {
+	class DescriptorBuffer;
+
 	struct CommandBufferUsage {
 		VkCommandBufferUsageFlags usage;
 	};
 
+	//what a secondary command buffer continues, framebuffer may stay null when unknown at record time.
+	//without a render pass the formats describe the beginRendering instance it continues
+	struct CommandBufferInheritance {
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		std::vector<VkFormat> colorAttachmentFormats;
+		VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+	};
+
+	//an image view rendered to by beginRendering, its layout has to be reached before
+	struct RenderingAttachment {
+		VkImageView imageView;
+		VkImageLayout imageLayout;
+		VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		VkClearValue clearValue{};
+	};
+
+	struct BufferBarrier {
+		const Buffer* buffer;
+		VkAccessFlags srcAccessMask;
+		VkAccessFlags dstAccessMask;
+		uint64_t offset = 0;
+		uint64_t size = VK_WHOLE_SIZE;
+		uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	};
+
+	//commands skipped by CommandBuffer because they would not have changed the bound state
+	struct CommandBufferStats {
+		uint64_t elidedPipelineBinds = 0;
+		uint64_t elidedVertexBufferBinds = 0;
+		uint64_t elidedIndexBufferBinds = 0;
+		uint64_t elidedDescriptorSetBinds = 0;
+		uint64_t elidedViewports = 0;
+		uint64_t elidedScissors = 0;
+
+		uint64_t getElidedCommandCount() const;
+	};
+
 	class CommandBuffer {
 	public:
-		CommandBuffer(std::shared_ptr<Device> device, VkCommandPool vkCommandPool, Queue queue);
+		CommandBuffer(std::shared_ptr<Device> device, VkCommandPool vkCommandPool, Queue queue, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 		CommandBuffer(CommandBuffer& other);
 		CommandBuffer(CommandBuffer&&) = delete;
 		CommandBuffer operator=(CommandBuffer& other);
@@ -24,51 +72,189 @@ namespace basicvk {
 		~CommandBuffer();
 
 		const VkCommandBuffer& getVkCommandBuffer() const;
+		VkCommandBufferLevel getLevel() const;
 
 		void beginCommandBuffer(CommandBufferUsage beginInfo) const;
+		//secondary buffers only, recorded to run inside the inherited render pass
+		void beginCommandBuffer(CommandBufferUsage beginInfo, const CommandBufferInheritance& inheritance) const;
 		void endCommandBuffer() const;
 		void resetCommandBuffer() const;
 
 		void CopyBuffer(const Buffer& src, const Buffer& dst) const;
+		void CopyBuffer(const Buffer& src, const Buffer& dst, const std::vector<VkBufferCopy>& regions) const;
 		void CopyBufferToTexture(const Buffer& src, const Texture& dest) const;
+		void CopyBufferToTexture(const Buffer& src, const Texture& dest, const std::vector<VkBufferImageCopy>& regions) const;
+		//queues the barrier to newLayout, see requireAccess
 		void transitionImageLayout(Texture& texture, VkFormat format, VkImageLayout newLayout) const;
 		void generateMipMap(Texture& texture) const;
 
-		void beginRenderPass(const GraphicPipeline& graphicPipeline, const Swapchain &swapchain, const Framebuffer& frameBuffer, uint32_t indexImage) const;
+		void beginRenderPass(const GraphicPipeline& graphicPipeline, const Swapchain &swapchain, const Framebuffer& frameBuffer, uint32_t indexImage,
+			VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const;
 		void endRenderPass() const;
+		//dynamic rendering, the attachments are given directly instead of through a render pass and a framebuffer.
+		//stencilAttachment is required when the pipeline declares a stencil format, it may reuse the depth view
+		void beginRendering(VkExtent2D extent, const std::vector<RenderingAttachment>& colorAttachments, const RenderingAttachment* depthAttachment,
+			VkRenderingFlags flags = 0, const RenderingAttachment* stencilAttachment = nullptr) const;
+		//renders to the swapchain image and the depth buffer of graphicPipeline, clearing both like beginRenderPass
+		void beginRendering(const GraphicPipeline& graphicPipeline, const Swapchain& swapchain, uint32_t indexImage, VkRenderingFlags flags = 0) const;
+		void endRendering() const;
+		//also moves the swapchain image to PRESENT_SRC_KHR, pairs with the swapchain beginRendering
+		void endRendering(const Swapchain& swapchain, uint32_t indexImage) const;
+		void executeCommands(const std::vector<std::shared_ptr<CommandBuffer>>& secondaryCommandBuffers) const;
 
 		void bindGraphicPipeline(const GraphicPipeline& graphicPipeline) const;
 		void bindVertexBuffer(const Buffer& vertexBuffer) const;
 		void bindIndexBuffer(const Buffer& indexBuffer, VkIndexType indexType) const;
 		void bindGraphicDescriptorSet(const GraphicPipeline& graphicPipeline, std::shared_ptr<DescriptorSet> descriptorSet) const;
+		void bindGraphicDescriptorSet(const GraphicPipeline& graphicPipeline, std::shared_ptr<DescriptorSet> descriptorSet, const std::vector<uint32_t>& dynamicOffsets) const;
+#ifdef VK_EXT_descriptor_buffer
+		//set written at offset by DescriptorBuffer::allocateSet, the pipeline needs descriptorBuffer
+		void bindGraphicDescriptorSet(const GraphicPipeline& graphicPipeline, const DescriptorBuffer& descriptorBuffer, VkDeviceSize offset, uint32_t set = 0) const;
+#endif
 		void draw(const Swapchain& swapchain, uint32_t vertexCount, uint32_t instanceCount) const;
 		void drawIndexed(const Swapchain& swapchain, uint32_t indexCount);
+		void drawIndexed(const Swapchain& swapchain, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) const;
+		//drawCount VkDrawIndexedIndirectCommand read from indirectBuffer, more than one needs DeviceFeatures::multiDrawIndirect
+		void drawIndexedIndirect(const Swapchain& swapchain, const Buffer& indirectBuffer, VkDeviceSize offset, uint32_t drawCount,
+			uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) const;
+		//the draw count is read by the gpu from countBuffer, needs DeviceFeatures::drawIndirectCount
+		void drawIndexedIndirectCount(const Swapchain& swapchain, const Buffer& indirectBuffer, VkDeviceSize offset, const Buffer& countBuffer, VkDeviceSize countOffset,
+			uint32_t maxDrawCount, uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) const;
+		void bindComputePipeline(const ComputePipeline& computePipeline) const;
+		void bindComputeDescriptorSet(const ComputePipeline& computePipeline, std::shared_ptr<DescriptorSet> descriptorSet) const;
+		void bindComputeDescriptorSet(const ComputePipeline& computePipeline, std::shared_ptr<DescriptorSet> descriptorSet, const std::vector<uint32_t>& dynamicOffsets) const;
+#ifdef VK_EXT_descriptor_buffer
+		void bindComputeDescriptorSet(const ComputePipeline& computePipeline, const DescriptorBuffer& descriptorBuffer, VkDeviceSize offset, uint32_t set = 0) const;
+#endif
+		void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const;
+		//reads a VkDispatchIndirectCommand written by an earlier pass, the buffer needs VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+		void dispatchIndirect(const Buffer& indirectBuffer, VkDeviceSize offset) const;
+
+		//offset and size must lie in a push constant range of the layout declared for stageFlags
+		void pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* data) const;
+		template<typename T>
+		void pushConstants(const GraphicPipeline& graphicPipeline, VkShaderStageFlags stageFlags, const T& value, uint32_t offset = 0) const
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "push constants are copied as raw bytes");
+			static_assert(sizeof(T) % 4 == 0, "push constant sizes are multiples of 4");
+			pushConstants(graphicPipeline.getVkPipelineLayout(), stageFlags, offset, sizeof(T), &value);
+		}
+		template<typename T>
+		void pushConstants(const ComputePipeline& computePipeline, const T& value, uint32_t offset = 0) const
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "push constants are copied as raw bytes");
+			static_assert(sizeof(T) % 4 == 0, "push constant sizes are multiples of 4");
+			pushConstants(computePipeline.getVkPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, offset, sizeof(T), &value);
+		}
+
+		void fillBuffer(const Buffer& buffer, uint32_t value, uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE) const;
+		void memoryBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) const;
+		void bufferBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, const std::vector<BufferBarrier>& barriers) const;
+
+		//derives the barrier the next commands need from the state recorded in the resource and queues it,
+		//every queued barrier goes out in one vkCmdPipelineBarrier2 before the next render pass, dispatch, copy, barrier or endCommandBuffer,
+		//so what a render pass reads has to be required before it begins.
+		//states live in the resources, a resource must be tracked in the order its command buffers are submitted
+		void requireAccess(Texture& texture, ResourceAccess access, uint32_t baseMipLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS) const;
+		void requireAccess(const Buffer& buffer, ResourceAccess access) const;
+		//single level image the tracker doesn't own, e.g. the depth buffer of a GraphicPipeline, the caller keeps its state
+		void requireAccess(VkImage image, VkImageAspectFlags aspectMask, ResourceState& state, ResourceAccess access) const;
+		void flushBarriers() const;
+
 		void QueueSubmit(const std::vector<const Semaphore*> &waitSemaphores, const std::vector<const Semaphore*> &signalSemaphores, const Fence* pFence) const;
 
+		//forget the shadowed state, needed after binding or setting state through getVkCommandBuffer()
+		void invalidateState() const;
+		const CommandBufferStats& getStats() const;
+		void resetStats() const;
+
 	private:
+		//graphics state as last recorded, binds matching it are not recorded again
+		struct BoundState {
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			VkPipeline computePipeline = VK_NULL_HANDLE;
+			VkBuffer vertexBuffer = VK_NULL_HANDLE;
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+			VkPipelineLayout descriptorSetLayout = VK_NULL_HANDLE;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			std::vector<uint32_t> dynamicOffsets;
+			VkBuffer descriptorBuffer = VK_NULL_HANDLE;
+			bool hasViewport = false;
+			VkViewport viewport{};
+			bool hasScissor = false;
+			VkRect2D scissor{};
+		};
+
+		//barriers queued by requireAccess, as sync2 structs even when they are recorded without synchronization2
+		struct PendingBarriers {
+			std::vector<VkImageMemoryBarrier2> imageBarriers;
+			std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+		};
+
+		void setViewportAndScissor(VkExtent2D extent) const;
+#ifdef VK_EXT_descriptor_buffer
+		void bindDescriptorBuffer(const DescriptorBuffer& descriptorBuffer) const;
+#endif
+
 		VkCommandBuffer commandBuffer;
 		std::shared_ptr<Device> device_ptr;
 		Queue queue;
+		VkCommandBufferLevel level;
+		mutable BoundState boundState;
+		mutable CommandBufferStats stats;
+		mutable PendingBarriers pendingBarriers;
 	};
 
 	class CommandPool {
 	public:
-		CommandPool(std::shared_ptr<Device> device, Queue queue);
+		CommandPool(std::shared_ptr<Device> device, Queue queue, VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 		CommandPool(CommandPool& other);
 		CommandPool(CommandPool&&) = delete;
 		CommandPool operator=(CommandPool& commandPool);
 		CommandPool operator=(CommandPool&&) = delete;
 		~CommandPool();
 
-		std::shared_ptr<CommandBuffer> allocateCommandBuffer();
+		std::shared_ptr<CommandBuffer> allocateCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 		const std::vector<std::shared_ptr<CommandBuffer>> &getCommandBuffers() const;
+		//hands out buffers recycled by reset() before allocating new ones
+		std::shared_ptr<CommandBuffer> acquireCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		//resets every buffer of the pool at once, none of them may still be pending
+		void reset();
 
 	private:
+		struct RecycledCommandBuffers {
+			std::vector<std::shared_ptr<CommandBuffer>> commandBuffers;
+			uint32_t used = 0;
+		};
+
 		std::vector<std::shared_ptr<CommandBuffer>> commandBuffers;
+		std::array<RecycledCommandBuffers, 2> recycledCommandBuffers;	//indexed by VkCommandBufferLevel
 		std::shared_ptr<Device> device_ptr;
 		VkCommandPool commandPool;
 		Queue queue;
 	};
+
+	//one transient pool per frame in flight, reset as a whole with vkResetCommandPool
+	//instead of tracking and resetting each command buffer
+	class CommandPoolRing {
+	public:
+		CommandPoolRing(std::shared_ptr<Device> device, Queue queue, uint32_t frameCount);
+		CommandPoolRing(const CommandPoolRing&) = delete;
+		CommandPoolRing(CommandPoolRing&&) = delete;
+		CommandPoolRing operator=(const CommandPoolRing&) = delete;
+		CommandPoolRing operator=(CommandPoolRing&&) = delete;
+
+		//only call once the fence of the previous submission of this frame has signaled
+		void beginFrame(uint32_t frameIndex);
+		std::shared_ptr<CommandBuffer> acquireCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		CommandPool& getCommandPool(uint32_t frameIndex) const;
+		uint32_t getFrameCount() const;
+
+	private:
+		std::vector<std::unique_ptr<CommandPool>> commandPools;
+		uint32_t currentFrame;
+	};
 }
 
 #endif // !VK_COMMAND_POOL_HPP_
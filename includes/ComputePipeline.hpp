@@ -0,0 +1,36 @@
+#ifndef VK_COMPUTE_PIPELINE_HPP_
+#define VK_COMPUTE_PIPELINE_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Shader.hpp>
+#include <Descriptors.hpp>
+#include <vector>
+
+namespace basicvk {
+	struct ComputePipelineInfo {
+		std::vector<const DescriptorSetLayout*> descriptorSetLayouts;	//set i uses descriptorSetLayouts[i]
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		bool descriptorBuffer = false;	//sets bound from a DescriptorBuffer, needs DeviceFeatures::descriptorBuffer
+	};
+
+	class ComputePipeline {
+	public:
+		ComputePipeline(std::shared_ptr<Device> device, const Shader& shader, ComputePipelineInfo pipelineInfo);
+		~ComputePipeline();
+		ComputePipeline(const ComputePipeline&) = delete;
+		ComputePipeline(ComputePipeline&&) = delete;
+		ComputePipeline operator=(const ComputePipeline&) = delete;
+		ComputePipeline operator=(ComputePipeline&&) = delete;
+
+		VkPipeline getVkComputePipeline() const;
+		VkPipelineLayout getVkPipelineLayout() const;
+
+	private:
+		std::shared_ptr<Device> device_ptr;
+		VkPipeline computePipeline;
+		VkPipelineLayout pipelineLayout;
+	};
+}
+
+#endif // !VK_COMPUTE_PIPELINE_HPP_
@@ -0,0 +1,69 @@
+#ifndef VK_DESCRIPTOR_ALLOCATOR_HPP_
+#define VK_DESCRIPTOR_ALLOCATOR_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Descriptors.hpp>
+#include <memory>
+#include <vector>
+
+namespace basicvk {
+	//descriptors of a type a pool holds per set it can allocate
+	struct DescriptorPoolRatio {
+		VkDescriptorType type;
+		float ratio;
+	};
+
+	struct DescriptorAllocatorOptions {
+		std::vector<DescriptorPoolRatio> ratios = {
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5f },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f },
+			{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f } };
+		uint32_t frameCount = 1;
+		uint32_t initialSetsPerPool = 64;
+		uint32_t maxSetsPerPool = 4096;
+		float growthFactor = 2.0f;	//each new pool of a frame holds that many times more sets than the previous one
+		VkDescriptorPoolCreateFlags flags = 0;
+	};
+
+	//hands out sets from a chain of pools per frame, a new pool is created when the current one runs out
+	//and every pool of a frame is reset at once when the frame begins again
+	class DescriptorAllocator {
+	public:
+		DescriptorAllocator(std::shared_ptr<Device> device, DescriptorAllocatorOptions options);
+		~DescriptorAllocator();
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator(DescriptorAllocator&&) = delete;
+		DescriptorAllocator operator=(const DescriptorAllocator&) = delete;
+		DescriptorAllocator operator=(DescriptorAllocator&&) = delete;
+
+		//only once the previous submission of this frame has completed, resetPools false keeps its sets alive
+		void beginFrame(uint32_t frameIndex, bool resetPools = true);
+		std::shared_ptr<DescriptorSet> allocate(const DescriptorSetLayout& layout);
+		//one vkAllocateDescriptorSets for every layout, the sets are returned in the same order
+		std::vector<std::shared_ptr<DescriptorSet>> allocate(const std::vector<const DescriptorSetLayout*>& layouts);
+
+		uint32_t getPoolCount() const;
+
+	private:
+		struct Frame {
+			std::vector<VkDescriptorPool> pools;
+			uint32_t currentPool = 0;
+		};
+
+		VkDescriptorPool createPool(uint32_t maxSets) const;
+		bool tryAllocate(VkDescriptorPool pool, const std::vector<VkDescriptorSetLayout>& layouts, std::vector<VkDescriptorSet>& sets) const;
+
+		std::shared_ptr<Device> device_ptr;
+		DescriptorAllocatorOptions options;
+		std::vector<Frame> frames;
+		uint32_t currentFrame;
+	};
+}
+
+#endif // !VK_DESCRIPTOR_ALLOCATOR_HPP_
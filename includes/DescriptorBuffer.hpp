@@ -0,0 +1,65 @@
+#ifndef VK_DESCRIPTOR_BUFFER_HPP_
+#define VK_DESCRIPTOR_BUFFER_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Descriptors.hpp>
+#include <memory>
+
+//VK_EXT_descriptor_buffer first ships in the 1.3.235 headers, older sdks leave DeviceFeatures::descriptorBuffer false
+#ifdef VK_EXT_descriptor_buffer
+namespace basicvk {
+	struct DescriptorBufferOptions {
+		VkDeviceSize size = 1024 * 1024;
+	};
+
+	//descriptors written with vkGetDescriptorEXT straight into a persistently mapped buffer, no pool nor VkDescriptorSet.
+	//sets are carved linearly out of the buffer and bound by offset with CommandBuffer::bindGraphicDescriptorSet.
+	//layouts need DESCRIPTOR_BUFFER_BIT_EXT and pipelines descriptorBuffer, a buffer per frame in flight lets reset() run
+	//once the frame's previous submission completed
+	class DescriptorBuffer {
+	public:
+		DescriptorBuffer(std::shared_ptr<Device> device, DescriptorBufferOptions options);
+		DescriptorBuffer(const DescriptorBuffer&) = delete;
+		DescriptorBuffer(DescriptorBuffer&&) = delete;
+		DescriptorBuffer operator=(const DescriptorBuffer&) = delete;
+		DescriptorBuffer operator=(DescriptorBuffer&&) = delete;
+
+		//returns the offset of the set, to write its descriptors and to bind it
+		VkDeviceSize allocateSet(const DescriptorSetLayout& layout);
+		void reset();
+
+		//range VK_WHOLE_SIZE covers the buffer from offset to its end
+		void writeBuffer(VkDeviceSize setOffset, const DescriptorSetLayout& layout, uint32_t binding, uint32_t arrayElement, VkDescriptorType type,
+			const Buffer& resource, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+		void writeTexture(VkDeviceSize setOffset, const DescriptorSetLayout& layout, const TextureUpdateInfo& textureInfo);
+		//makes the writes visible to the gpu on non coherent memory, before the submission using them
+		void flush();
+
+		void cmdBind(VkCommandBuffer commandBuffer) const;
+		void cmdSetOffset(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, VkDeviceSize offset) const;
+
+		VkBuffer getVkBuffer() const;
+		VkDeviceSize getUsedSize() const;
+
+	private:
+		static VkPhysicalDeviceDescriptorBufferPropertiesEXT getProperties(std::shared_ptr<Device> device);
+		size_t getDescriptorSize(VkDescriptorType type) const;
+		void write(VkDeviceSize setOffset, const DescriptorSetLayout& layout, uint32_t binding, uint32_t arrayElement, const VkDescriptorGetInfoEXT& getInfo);
+
+		std::shared_ptr<Device> device_ptr;
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT properties;
+		Buffer buffer;
+		VkDeviceAddress address;
+		VkDeviceSize usedSize;
+		PFN_vkGetDescriptorSetLayoutSizeEXT getDescriptorSetLayoutSize;
+		PFN_vkGetDescriptorSetLayoutBindingOffsetEXT getDescriptorSetLayoutBindingOffset;
+		PFN_vkGetDescriptorEXT getDescriptor;
+		PFN_vkCmdBindDescriptorBuffersEXT cmdBindDescriptorBuffers;
+		PFN_vkCmdSetDescriptorBufferOffsetsEXT cmdSetDescriptorBufferOffsets;
+	};
+}
+#endif
+
+#endif // !VK_DESCRIPTOR_BUFFER_HPP_
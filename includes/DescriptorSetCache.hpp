@@ -0,0 +1,91 @@
+#ifndef VK_DESCRIPTOR_SET_CACHE_HPP_
+#define VK_DESCRIPTOR_SET_CACHE_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Descriptors.hpp>
+#include <DescriptorAllocator.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace basicvk {
+	//one descriptor of a set, buffer fields for buffer descriptors and image fields for image and sampler descriptors
+	struct DescriptorResource {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize range = VK_WHOLE_SIZE;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		bool operator==(const DescriptorResource& other) const;
+	};
+
+	struct DescriptorSetCacheOptions {
+		uint32_t frameCount = 2;
+		uint32_t setsPerPool = 256;	//first pool of each frame, later ones grow
+	};
+
+	//returns an already written set when the same layout and resources were asked for, sets are written in one
+	//vkUpdateDescriptorSetWithTemplate call. every frame has its own sets, they are kept as long as all of them are
+	//asked for again each time the frame comes back, otherwise the frame is recycled as a whole
+	class DescriptorSetCache {
+	public:
+		DescriptorSetCache(std::shared_ptr<Device> device, DescriptorSetCacheOptions options);
+		~DescriptorSetCache();
+		DescriptorSetCache(const DescriptorSetCache&) = delete;
+		DescriptorSetCache(DescriptorSetCache&&) = delete;
+		DescriptorSetCache operator=(const DescriptorSetCache&) = delete;
+		DescriptorSetCache operator=(DescriptorSetCache&&) = delete;
+
+		//only once the previous submission of this frame has completed
+		void beginFrame(uint32_t frameIndex);
+		//recycles every frame when it begins next, needed once a resource referenced by a cached set is destroyed
+		void invalidate();
+		//one resource per descriptor, bindings in the order of the layout create info, array elements in order
+		std::shared_ptr<DescriptorSet> getDescriptorSet(const DescriptorSetLayout& layout, const std::vector<DescriptorResource>& resources);
+
+		uint64_t getHitCount() const;
+		uint64_t getMissCount() const;
+
+	private:
+		//a buffer and an image info have the same size, the template reads either at a fixed stride
+		union DescriptorData {
+			VkDescriptorBufferInfo buffer;
+			VkDescriptorImageInfo image;
+		};
+
+		struct UpdateTemplate {
+			VkDescriptorUpdateTemplate updateTemplate;
+			std::vector<bool> isBuffer;	//per descriptor
+		};
+
+		struct CachedSet {
+			VkDescriptorSetLayout layout;
+			std::vector<DescriptorResource> resources;
+			std::shared_ptr<DescriptorSet> descriptorSet;
+			bool used;	//since the frame last began
+		};
+
+		struct Frame {
+			std::unordered_multimap<size_t, CachedSet> sets;
+			bool invalidated = false;
+		};
+
+		const UpdateTemplate& getUpdateTemplate(const DescriptorSetLayout& layout);
+		static size_t hash(VkDescriptorSetLayout layout, const std::vector<DescriptorResource>& resources);
+
+		std::shared_ptr<Device> device_ptr;
+		DescriptorSetCacheOptions options;
+		DescriptorAllocator allocator;
+		std::vector<Frame> frames;
+		uint32_t currentFrame;
+		std::unordered_map<VkDescriptorSetLayout, UpdateTemplate> templates;
+		std::vector<DescriptorData> scratch;
+		uint64_t hitCount;
+		uint64_t missCount;
+	};
+}
+
+#endif // !VK_DESCRIPTOR_SET_CACHE_HPP_
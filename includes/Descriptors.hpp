@@ -13,22 +13,27 @@ namespace basicvk {
 	struct DescriptorPoolCreateInfo {
 		std::vector<VkDescriptorPoolSize> poolSizes;
 		uint32_t maxSets;
+		VkDescriptorPoolCreateFlags flags = 0;	//UPDATE_AFTER_BIND_BIT for layouts with update after bind bindings
 	};
 
 	struct DescriptorSetAllocateInfo {
 		VkDescriptorPool descriptorPool;
 		VkDescriptorSetLayout descriptorSetLayout;
+		uint32_t variableDescriptorCount = 0;	//size of the last binding when it has VARIABLE_DESCRIPTOR_COUNT_BIT
 	};
 
+	//binding flags other than 0 need DeviceFeatures::descriptorIndexing
 	struct DescriptorSetLayoutCreateInfo {
 		uint32_t binding;
 		VkDescriptorType descriptorType;
 		VkShaderStageFlags shaderStage;
 		uint32_t descriptorCount;
+		VkDescriptorBindingFlags bindingFlags = 0;
 	};
 
 	struct BufferUpdateInfo {
 		VkBuffer buffer;
+		uint64_t offset;
 		uint64_t range;
 		uint32_t binding;
 		uint32_t arrayElement;
@@ -41,6 +46,7 @@ namespace basicvk {
 		VkSampler sampler;
 		uint32_t binding;
 		uint32_t arrayElement;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	};
 
 	struct DescriptorSetUpdateInfo {
@@ -57,9 +63,11 @@ namespace basicvk {
 		DescriptorPool(DescriptorPool&&) = delete;
 		DescriptorPool operator=(DescriptorPool&&) = delete;
 
-		std::shared_ptr<DescriptorSet> allocateDescriptorSet(const DescriptorSetLayout &descriptorSetLayout);
+		std::shared_ptr<DescriptorSet> allocateDescriptorSet(const DescriptorSetLayout &descriptorSetLayout, uint32_t variableDescriptorCount = 0);
 		const std::vector<std::shared_ptr<DescriptorSet>> & getDescriptorSets() const;
 		std::vector<VkDescriptorSet> getVkDescriptorSets() const;
+		//every set allocated from the pool returns to it, only once no submission uses them anymore
+		void reset();
 
 	private:
 		VkDescriptorPool descriptorPool;
@@ -70,6 +78,8 @@ namespace basicvk {
 	class DescriptorSet {
 	public:
 		DescriptorSet(std::shared_ptr<Device> device, DescriptorSetAllocateInfo allocateInfo);
+		//wraps a set allocated elsewhere, it still belongs to its pool
+		DescriptorSet(std::shared_ptr<Device> device, VkDescriptorSet descriptorSet);
 		DescriptorSet(DescriptorSet& other);
 		DescriptorSet operator=(DescriptorSet& other);
 		DescriptorSet(DescriptorSet&&) = delete;
@@ -77,6 +87,8 @@ namespace basicvk {
 
 		VkDescriptorSet getVkDescriptorSet() const;
 		void UpdateDescriptorSet(DescriptorSetUpdateInfo descriptorSetUpdateInfo) const;
+		//writes the whole set in one call, data is laid out as described by the template entries
+		void UpdateDescriptorSet(VkDescriptorUpdateTemplate updateTemplate, const void* data) const;
 
 	private:
 		VkDescriptorSet descriptorSet;
@@ -85,7 +97,8 @@ namespace basicvk {
 
 	class DescriptorSetLayout {
 	public:
-		DescriptorSetLayout(std::shared_ptr<Device> device, const std::vector<DescriptorSetLayoutCreateInfo> &createInfo);
+		//DESCRIPTOR_BUFFER_BIT_EXT in flags for layouts written through a DescriptorBuffer
+		DescriptorSetLayout(std::shared_ptr<Device> device, const std::vector<DescriptorSetLayoutCreateInfo> &createInfo, VkDescriptorSetLayoutCreateFlags flags = 0);
 		~DescriptorSetLayout();
 		DescriptorSetLayout(DescriptorSetLayout& other);
 		DescriptorSetLayout operator=(DescriptorSetLayout& other);
@@ -93,9 +106,11 @@ namespace basicvk {
 		DescriptorSetLayout operator=(DescriptorSetLayout&&) = delete;
 
 		VkDescriptorSetLayout getVkDescriptorSetLayout() const;
+		const std::vector<DescriptorSetLayoutCreateInfo>& getBindings() const;
 
 	private:
 		VkDescriptorSetLayout descriptorSetLayout;
+		std::vector<DescriptorSetLayoutCreateInfo> bindings;
 		std::shared_ptr<Device> device_ptr;
 	};
 }
@@ -4,6 +4,8 @@
 #include <vulkan/vulkan.hpp>
 #include <VulkanBasic.hpp>
 #include <PhysicalDevice.hpp>
+#include <Allocator.hpp>
+#include <Sampler.hpp>
 #include <memory>
 #include <optional>
 
@@ -14,7 +16,7 @@ namespace basicvk {
 	public:
 		Queue();
 		Queue(VkQueue queue, uint32_t indice);
-		Queue(Queue& queue) = default;
+		Queue(const Queue& queue) = default;
 
 		void waitIdle() const;
 
@@ -27,6 +29,19 @@ namespace basicvk {
 
 	};
 
+	//optional capabilities, each one is enabled at device creation when the physical device supports it
+	struct DeviceFeatures {
+		bool multiDrawIndirect = false;
+		bool drawIndirectFirstInstance = false;
+		bool drawIndirectCount = false;
+		bool timelineSemaphore = false;
+		bool synchronization2 = false;
+		bool dynamicRendering = false;
+		bool descriptorIndexing = false;	//runtime sized, partially bound and update after bind arrays, non uniform indexing
+		bool bufferDeviceAddress = false;
+		bool descriptorBuffer = false;	//VK_EXT_descriptor_buffer, descriptors written straight into buffer memory
+	};
+
 	class Device {
 	public:
 		Device(std::shared_ptr<PhysicalDevice> physicalDevicePtr);
@@ -43,11 +58,21 @@ namespace basicvk {
 		VkDevice getVkDevice() const;
 		Queue getGraphicQueue() const;
 		Queue getPresentQueue() const;
+		//dedicated queues when the device has them, the graphic queue otherwise.
+		//exclusive resources used across two families need a release and an acquire BufferBarrier
+		Queue getTransferQueue() const;
+		Queue getComputeQueue() const;
 		std::shared_ptr<PhysicalDevice> getPhysicalDevice() const;
+		MemoryAllocator& getMemoryAllocator() const;
+		SamplerCache& getSamplerCache() const;
+		const DeviceFeatures& getFeatures() const;
 
 	private:
 		VkDevice device;
 		std::shared_ptr<PhysicalDevice> physicalDevice;
+		DeviceFeatures features;
+		std::unique_ptr<MemoryAllocator> memoryAllocator;
+		std::unique_ptr<SamplerCache> samplerCache;
 	};
 }
 
@@ -0,0 +1,60 @@
+#ifndef VK_FRAME_ALLOCATOR_HPP_
+#define VK_FRAME_ALLOCATOR_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <memory>
+#include <vector>
+
+namespace basicvk {
+	struct FrameAllocatorOptions {
+		uint32_t frameCount;
+		uint64_t bufferSize = 4ull * 1024 * 1024;
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	};
+
+	struct TransientAllocation {
+		const Buffer* buffer;
+		uint32_t offset;	//to pass as dynamic offset when binding the descriptor set
+		void* data;
+	};
+
+	//bump allocator over one persistently mapped buffer per frame in flight,
+	//everything allocated during a frame is released at once by the next beginFrame on the same index
+	class FrameAllocator {
+	public:
+		FrameAllocator(std::shared_ptr<Device> device, FrameAllocatorOptions options);
+		~FrameAllocator();
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator(FrameAllocator&&) = delete;
+		FrameAllocator operator=(const FrameAllocator&) = delete;
+		FrameAllocator operator=(FrameAllocator&&) = delete;
+
+		//only call once the fence of the previous submission using frameIndex has signaled
+		void beginFrame(uint32_t frameIndex);
+		TransientAllocation allocate(uint64_t size);
+		void flush() const;
+
+		template<typename T>
+		TransientAllocation push(const T& value)
+		{
+			TransientAllocation allocation = allocate(sizeof(T));
+			memcpy(allocation.data, &value, sizeof(T));
+			return allocation;
+		}
+
+		const Buffer& getBuffer(uint32_t frameIndex) const;
+		uint64_t getAlignment() const;
+
+	private:
+		std::shared_ptr<Device> device_ptr;
+		std::vector<std::unique_ptr<Buffer>> buffers;
+		uint64_t bufferSize;
+		uint64_t alignment;
+		uint32_t currentFrame;
+		uint64_t head;
+	};
+}
+
+#endif // !VK_FRAME_ALLOCATOR_HPP_
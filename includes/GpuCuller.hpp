@@ -0,0 +1,106 @@
+#ifndef VK_GPU_CULLER_HPP_
+#define VK_GPU_CULLER_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <Descriptors.hpp>
+#include <ComputePipeline.hpp>
+#include <GraphicPipeline.hpp>
+#include <IndirectDraw.hpp>
+#include <Swapchain.hpp>
+#include <Upload.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace basicvk {
+	struct GpuCullerOptions {
+		std::string cullShaderPath;	//compiled shaders/cull.comp
+		std::string hiZShaderPath;	//compiled shaders/hiz.comp
+		uint32_t frameCount;
+		uint32_t maxObjects = 65536;
+	};
+
+	//matches the CullObject of shaders/cull.comp, the object index is passed to the draw as firstInstance
+	//when DeviceFeatures::drawIndirectFirstInstance is available
+	struct CullObject {
+		float center[3];
+		float radius;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t padding;
+	};
+
+	//culls bounding spheres against the camera frustum and the hierarchical depth of the previous frame
+	//in a compute shader, survivors are compacted into an indirect buffer drawn with drawIndexedIndirectCount.
+	//per frame : cull() outside the render pass, draw() inside it, buildHiZ() once it has ended
+	class GpuCuller {
+	public:
+		static const uint32_t MAX_HIZ_LEVELS = 16;
+
+		GpuCuller(std::shared_ptr<Device> device, const GraphicPipeline& graphicPipeline, const Swapchain& swapchain, GpuCullerOptions options);
+		~GpuCuller();
+		GpuCuller(const GpuCuller&) = delete;
+		GpuCuller(GpuCuller&&) = delete;
+		GpuCuller operator=(const GpuCuller&) = delete;
+		GpuCuller operator=(GpuCuller&&) = delete;
+
+		static CullObject makeObject(const MeshRange& mesh, const float center[3], float radius);
+		//objects are persistent, returns the index of the first one. copied on the next uploadManager.submit()
+		uint32_t addObjects(UploadManager& uploadManager, const std::vector<CullObject>& objects);
+
+		//only call once the previous submission of this frame has completed
+		void beginFrame(uint32_t frameIndex);
+		//viewProjection is column major with a 0..1 depth range, as built by glm with GLM_FORCE_DEPTH_ZERO_TO_ONE
+		void cull(const CommandBuffer& commandBuffer, const float viewProjection[16]);
+		void draw(const CommandBuffer& commandBuffer, const Swapchain& swapchain) const;
+		//reduces the depth buffer of the frame into the pyramid tested by the next cull()
+		void buildHiZ(const CommandBuffer& commandBuffer);
+		//rebuilds the pyramid for a recreated pipeline or swapchain, once no submission uses the culler anymore
+		void resize(const GraphicPipeline& graphicPipeline, const Swapchain& swapchain);
+
+		bool isOcclusionSupported() const;
+		uint32_t getObjectCount() const;
+		const Buffer& getDrawBuffer(uint32_t frameIndex) const;
+
+	private:
+		struct FrameResources {
+			std::unique_ptr<Buffer> drawBuffer;
+			std::unique_ptr<Buffer> countBuffer;
+			std::shared_ptr<DescriptorSet> descriptorSet;
+		};
+
+		void createHiZ(const GraphicPipeline& graphicPipeline, const Swapchain& swapchain);
+		void destroyHiZ();
+		VkImageView createLevelView(uint32_t level) const;
+
+		std::shared_ptr<Device> device_ptr;
+		GpuCullerOptions options;
+		DepthBuffer depthBuffer;
+		VkImageAspectFlags depthAspect;
+		bool occlusionSupported;
+		bool compact;
+		DescriptorSetLayout cullSetLayout;
+		DescriptorSetLayout hiZSetLayout;
+		DescriptorPool descriptorPool;
+		ComputePipeline cullPipeline;
+		ComputePipeline hiZPipeline;
+		std::unique_ptr<Buffer> objectBuffer;
+		std::unique_ptr<Buffer> paramsBuffer;
+		uint64_t paramsStride;
+		std::unique_ptr<Texture> hiZ;
+		std::vector<VkImageView> hiZLevelViews;
+		std::vector<std::shared_ptr<DescriptorSet>> hiZDescriptorSets;
+		std::vector<FrameResources> frames;
+		uint32_t objectCount;
+		uint32_t currentFrame;
+		float viewProjection[16];
+		float hiZViewProjection[16];
+		bool hiZValid;
+	};
+}
+
+#endif // !VK_GPU_CULLER_HPP_
@@ -12,6 +12,15 @@ namespace basicvk {
 		VkVertexInputBindingDescription* vertexInputBindingDescription;
 		std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
 		DescriptorSetLayout *descriptorSetLayout;
+		//small per draw data sent with CommandBuffer::pushConstants, at most maxPushConstantsSize bytes (128 guaranteed)
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		//no VkRenderPass nor Framebuffer, draws go between CommandBuffer::beginRendering and endRendering.
+		//needs DeviceFeatures::dynamicRendering
+		bool dynamicRendering = false;
+		//sets are bound from a DescriptorBuffer instead of DescriptorSets, needs DeviceFeatures::descriptorBuffer
+		bool descriptorBuffer = false;
+		//STORE when the depth is read after the pass, e.g. by the hierarchical depth of a GpuCuller
+		VkAttachmentStoreOp depthStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	};
 
 	struct DepthBuffer {
@@ -29,7 +38,11 @@ namespace basicvk {
 		GraphicPipeline(GraphicPipeline&&) = delete;
 		GraphicPipeline operator=(GraphicPipeline&&) = delete;
 
+		//VK_NULL_HANDLE with dynamic rendering
 		VkRenderPass getVkRenderPass() const;
+		VkFormat getColorFormat() const;
+		VkFormat getDepthFormat() const;
+		VkAttachmentStoreOp getDepthStoreOp() const;
 		VkPipeline getVkGraphicPipeline() const;
 		VkPipelineLayout getVkPipelineLayout() const;
 		DepthBuffer getDepthBuffer() const;
@@ -39,6 +52,9 @@ namespace basicvk {
 		VkPipeline graphicPipeline;
 		VkPipelineLayout pipelineLayout;
 		VkRenderPass renderPass;
+		VkFormat colorFormat;
+		VkFormat depthFormat;
+		VkAttachmentStoreOp depthStoreOp;
 		DepthBuffer depthBuffer;
 	};
 }
@@ -0,0 +1,96 @@
+#ifndef VK_INDIRECT_DRAW_HPP_
+#define VK_INDIRECT_DRAW_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <Swapchain.hpp>
+#include <Upload.hpp>
+#include <memory>
+#include <vector>
+
+namespace basicvk {
+	struct MeshPoolOptions {
+		uint32_t vertexStride;
+		uint32_t maxVertices;
+		uint32_t maxIndices;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	};
+
+	//where a mesh lives inside the shared buffers of its MeshPool
+	struct MeshRange {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+	};
+
+	//every mesh shares one vertex buffer and one index buffer, so a whole scene is drawn
+	//with a single bind and per draw firstIndex/vertexOffset. meshes are never removed
+	class MeshPool {
+	public:
+		MeshPool(std::shared_ptr<Device> device, MeshPoolOptions options);
+		MeshPool(const MeshPool&) = delete;
+		MeshPool(MeshPool&&) = delete;
+		MeshPool operator=(const MeshPool&) = delete;
+		MeshPool operator=(MeshPool&&) = delete;
+
+		//indices are relative to the mesh vertices, the data is copied on the next uploadManager.submit()
+		MeshRange addMesh(UploadManager& uploadManager, const void* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount);
+		void bind(const CommandBuffer& commandBuffer) const;
+
+		const Buffer& getVertexBuffer() const;
+		const Buffer& getIndexBuffer() const;
+		VkIndexType getIndexType() const;
+		uint32_t getVertexCount() const;
+		uint32_t getIndexCount() const;
+
+	private:
+		std::shared_ptr<Device> device_ptr;
+		MeshPoolOptions options;
+		uint32_t indexSize;
+		std::unique_ptr<Buffer> vertexBuffer;
+		std::unique_ptr<Buffer> indexBuffer;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+	};
+
+	struct IndirectDrawListOptions {
+		uint32_t frameCount;
+		uint32_t maxDraws = 4096;
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	};
+
+	//per frame array of VkDrawIndexedIndirectCommand, filled on the cpu and consumed
+	//by one vkCmdDrawIndexedIndirect whatever the number of objects
+	class IndirectDrawList {
+	public:
+		IndirectDrawList(std::shared_ptr<Device> device, IndirectDrawListOptions options);
+		IndirectDrawList(const IndirectDrawList&) = delete;
+		IndirectDrawList(IndirectDrawList&&) = delete;
+		IndirectDrawList operator=(const IndirectDrawList&) = delete;
+		IndirectDrawList operator=(IndirectDrawList&&) = delete;
+
+		//clears the list of the frame, only call once its previous submission has completed
+		void beginFrame(uint32_t frameIndex);
+		//returns the index of the draw, firstInstance can be used by shaders to find per draw data
+		uint32_t add(const MeshRange& mesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+		void flush();
+		void draw(const CommandBuffer& commandBuffer, const Swapchain& swapchain) const;
+
+		const Buffer& getBuffer(uint32_t frameIndex) const;
+		uint32_t getDrawCount() const;
+		uint32_t getMaxDraws() const;
+
+	private:
+		std::shared_ptr<Device> device_ptr;
+		IndirectDrawListOptions options;
+		std::vector<std::unique_ptr<Buffer>> buffers;
+		std::vector<MappedSpan<VkDrawIndexedIndirectCommand>> commands;
+		uint32_t maxDrawIndirectCount;
+		uint32_t currentFrame;
+		uint32_t drawCount;
+	};
+}
+
+#endif // !VK_INDIRECT_DRAW_HPP_
@@ -0,0 +1,66 @@
+#ifndef VK_MIPMAP_GENERATOR_HPP_
+#define VK_MIPMAP_GENERATOR_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <Descriptors.hpp>
+#include <ComputePipeline.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace basicvk {
+	struct MipmapGeneratorOptions {
+		std::string shaderPath;	//compiled shaders/downsample.comp
+		uint32_t maxTexturesPerBatch = 64;
+	};
+
+	//builds a whole mip chain with a single compute dispatch instead of a blit and two barriers per level.
+	//levels are read and written as storage images, so the format needs storage support but no linear filtering.
+	//textures need getRequiredImageUsage() and getRequiredImageFlags(format) at creation
+	class MipmapGenerator {
+	public:
+		static const uint32_t MAX_MIP_LEVELS = 13;
+		//the last workgroup reduces a single 64x64 tile of mip 6, larger textures go through the blit path
+		static const uint32_t MAX_EXTENT = 4096;
+
+		MipmapGenerator(std::shared_ptr<Device> device, MipmapGeneratorOptions options);
+		~MipmapGenerator();
+		MipmapGenerator(const MipmapGenerator&) = delete;
+		MipmapGenerator(MipmapGenerator&&) = delete;
+		MipmapGenerator operator=(const MipmapGenerator&) = delete;
+		MipmapGenerator operator=(MipmapGenerator&&) = delete;
+
+		static VkImageUsageFlags getRequiredImageUsage();
+		static VkImageCreateFlags getRequiredImageFlags(VkFormat format);
+		bool isSupported(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels) const;
+
+		//level 0 must be filled, the texture ends in SHADER_READ_ONLY_OPTIMAL like generateMipMap
+		void generate(const CommandBuffer& commandBuffer, Texture& texture);
+		//only call once every submission recorded since the previous reset has completed
+		void reset();
+
+	private:
+		struct Job {
+			std::shared_ptr<DescriptorSet> descriptorSet;
+			std::vector<VkImageView> views;
+		};
+
+		static VkFormat getStorageFormat(VkFormat format);
+		VkImageView createStorageView(const Texture& texture, uint32_t mipLevel) const;
+
+		std::shared_ptr<Device> device_ptr;
+		DescriptorSetLayout descriptorSetLayout;
+		DescriptorPool descriptorPool;
+		ComputePipeline pipeline;
+		std::unique_ptr<Buffer> counterBuffer;
+		uint64_t counterStride;
+		std::vector<Job> jobs;
+		uint32_t usedJobs;
+		bool countersCleared;
+	};
+}
+
+#endif // !VK_MIPMAP_GENERATOR_HPP_
@@ -0,0 +1,51 @@
+#ifndef VK_PARALLEL_RECORDER_HPP_
+#define VK_PARALLEL_RECORDER_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Command.hpp>
+#include <ThreadPool.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace basicvk {
+	struct ParallelRecorderOptions {
+		uint32_t frameCount;
+		uint32_t workerCount = 0;	//0 uses one worker per hardware thread
+		uint32_t minDrawsPerWorker = 256;	//smaller lists are split over fewer workers
+	};
+
+	//records a draw list into secondary command buffers from a thread pool.
+	//every worker slot owns one transient command pool per frame in flight, so no pool is ever shared between threads
+	class ParallelRecorder {
+	public:
+		//called on a worker thread with a begun secondary buffer, records draws [first, first + count)
+		using RecordFunction = std::function<void(CommandBuffer& commandBuffer, uint32_t first, uint32_t count)>;
+
+		ParallelRecorder(std::shared_ptr<Device> device, Queue queue, ParallelRecorderOptions options);
+		~ParallelRecorder();
+		ParallelRecorder(const ParallelRecorder&) = delete;
+		ParallelRecorder(ParallelRecorder&&) = delete;
+		ParallelRecorder operator=(const ParallelRecorder&) = delete;
+		ParallelRecorder operator=(ParallelRecorder&&) = delete;
+
+		//resets the pools of the frame, only call once its previous submission has completed
+		void beginFrame(uint32_t frameIndex);
+		//the primary must be inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+		//secondaries are executed in draw order once every worker is done
+		void record(const CommandBuffer& primary, const CommandBufferInheritance& inheritance, uint32_t drawCount, const RecordFunction& recordRange);
+
+		uint32_t getWorkerCount() const;
+
+	private:
+		std::shared_ptr<Device> device_ptr;
+		ParallelRecorderOptions options;
+		uint32_t workerCount;
+		std::vector<std::vector<std::unique_ptr<CommandPool>>> framePools;
+		uint32_t currentFrame;
+		ThreadPool threadPool;
+	};
+}
+
+#endif // !VK_PARALLEL_RECORDER_HPP_
@@ -11,6 +11,9 @@ namespace basicvk {
 	struct QueueFamilyIndices {
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		//families without graphics support, left empty when the device only exposes shared ones
+		std::optional<uint32_t> transferFamily;
+		std::optional<uint32_t> computeFamily;
 	};
 
 	class PhysicalDevice {
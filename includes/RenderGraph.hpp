@@ -0,0 +1,112 @@
+#ifndef VK_RENDER_GRAPH_HPP_
+#define VK_RENDER_GRAPH_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <ResourceState.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace basicvk {
+	class RenderGraph;
+
+	//transient textures are created by the graph, their usage comes from the accesses of the passes
+	struct RenderGraphTextureDescription {
+		uint32_t width;
+		uint32_t height;
+		VkFormat format;
+		uint32_t mipLevels = 1;
+	};
+
+	struct RenderGraphAccess {
+		uint32_t resource;
+		ResourceAccess access;
+	};
+
+	using RenderGraphPassFunction = std::function<void(const CommandBuffer&, RenderGraph&)>;
+
+	//passes declare the resources they access and run in declaration order.
+	//compile() drops the passes nothing depends on and places transients whose lifetimes don't overlap in the same memory,
+	//execute() records the barriers of every pass through CommandBuffer::requireAccess before calling it
+	class RenderGraph {
+	public:
+		RenderGraph(std::shared_ptr<Device> device);
+		~RenderGraph();
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph(RenderGraph&&) = delete;
+		RenderGraph operator=(const RenderGraph&) = delete;
+		RenderGraph operator=(RenderGraph&&) = delete;
+
+		uint32_t createTexture(const std::string& name, RenderGraphTextureDescription description);
+		//imported resources keep their content after the graph, passes writing them are never culled
+		uint32_t importTexture(const std::string& name, Texture& texture);
+		uint32_t importBuffer(const std::string& name, const Buffer& buffer);
+		//passes with side effects write something the graph does not see, like a swapchain framebuffer
+		void addPass(const std::string& name, std::vector<RenderGraphAccess> accesses, RenderGraphPassFunction record, bool sideEffects = false);
+
+		void compile();
+		void execute(const CommandBuffer& commandBuffer);
+		//drops passes and transients, only call once every submission of execute has completed
+		void reset();
+
+		uint32_t getResource(const std::string& name) const;
+		Texture& getTexture(uint32_t resource);
+		const Buffer& getBuffer(uint32_t resource) const;
+		uint32_t getCulledPassCount() const;
+		//memory of the transients with and without aliasing
+		VkDeviceSize getTransientMemorySize() const;
+		VkDeviceSize getUnaliasedMemorySize() const;
+
+	private:
+		struct Resource {
+			std::string name;
+			RenderGraphTextureDescription description;
+			Texture* texture;
+			const Buffer* buffer;
+			bool imported;
+			VkImageUsageFlags usage;
+			uint32_t firstPass;
+			uint32_t lastPass;
+			uint32_t slot;
+			std::unique_ptr<Texture> transient;
+		};
+
+		struct Pass {
+			std::string name;
+			std::vector<RenderGraphAccess> accesses;
+			RenderGraphPassFunction record;
+			bool sideEffects;
+			bool culled;
+		};
+
+		//memory shared by transients used by disjoint ranges of passes
+		struct MemorySlot {
+			VkMemoryRequirements requirements;
+			std::vector<uint32_t> resources;
+			MemoryAllocation allocation;
+			uint32_t occupant;	//transient whose content the memory holds, UINT32_MAX before the first execute
+		};
+
+		uint32_t addResource(const std::string& name);
+		void cullPasses();
+		void computeLifetimes();
+		void allocateTransients(const std::vector<VkMemoryRequirements>& requirements);
+		void beginTransient(uint32_t id);
+		void destroyTransients();
+
+		std::shared_ptr<Device> device_ptr;
+		std::vector<Resource> resources;
+		std::unordered_map<std::string, uint32_t> resourceNames;
+		std::vector<Pass> passes;
+		std::vector<MemorySlot> slots;
+		VkDeviceSize unaliasedMemorySize;
+		bool compiled;
+	};
+}
+
+#endif // !VK_RENDER_GRAPH_HPP_
@@ -0,0 +1,66 @@
+#ifndef VK_RESOURCE_STATE_HPP_
+#define VK_RESOURCE_STATE_HPP_
+
+#include <vulkan/vulkan.hpp>
+
+namespace basicvk {
+	//how a command is about to use a buffer or an image subresource, see CommandBuffer::requireAccess
+	enum class ResourceAccess {
+		IndirectRead,
+		IndexRead,
+		VertexRead,
+		UniformRead,
+		FragmentSampledRead,
+		ComputeSampledRead,
+		ComputeStorageRead,
+		ComputeStorageWrite,
+		ComputeStorageReadWrite,
+		ColorAttachmentWrite,
+		DepthAttachmentWrite,
+		DepthAttachmentRead,
+		TransferRead,
+		TransferWrite,
+		HostWrite,
+		Present
+	};
+
+	//only uses stages and accesses that also exist without synchronization2, so they can be narrowed to the old flags
+	struct AccessInfo {
+		VkPipelineStageFlags2 stageMask;
+		VkAccessFlags2 accessMask;
+		VkImageLayout layout;	//VK_IMAGE_LAYOUT_UNDEFINED for buffer only accesses
+		bool write;
+	};
+
+	AccessInfo getAccessInfo(ResourceAccess access);
+
+	//last write of a resource or layout transition, and the reads already synchronized with it
+	struct ResourceState {
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags2 writeStageMask = VK_PIPELINE_STAGE_2_NONE;
+		VkAccessFlags2 writeAccessMask = VK_ACCESS_2_NONE;
+		VkPipelineStageFlags2 readStageMask = VK_PIPELINE_STAGE_2_NONE;
+		VkAccessFlags2 readAccessMask = VK_ACCESS_2_NONE;
+		uint32_t visibleReads = 0;	//bit per ResourceAccess whose barrier since the last write already covers its stages and accesses
+	};
+
+	struct StateTransition {
+		VkPipelineStageFlags2 srcStageMask;
+		VkAccessFlags2 srcAccessMask;
+		VkPipelineStageFlags2 dstStageMask;
+		VkAccessFlags2 dstAccessMask;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+	};
+
+	//moves state to access, returns false when the access needs no barrier. buffers keep an undefined layout
+	bool transitionState(ResourceState& state, ResourceAccess access, bool isImage, StateTransition& transition);
+	//state after work the tracker did not see, anything may have written the resource
+	ResourceState getUnknownState(VkImageLayout layout);
+	//every aspect of the format, for barriers and attachments
+	VkImageAspectFlags getImageAspectMask(VkFormat format);
+	//a single aspect, sampled descriptors can't read depth and stencil through one view
+	VkImageAspectFlags getImageViewAspectMask(VkFormat format);
+}
+
+#endif // !VK_RESOURCE_STATE_HPP_
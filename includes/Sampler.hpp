@@ -0,0 +1,56 @@
+#ifndef VK_SAMPLER_HPP_
+#define VK_SAMPLER_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <PhysicalDevice.hpp>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace basicvk {
+	struct SamplerDescription {
+		VkFilter magFilter = VK_FILTER_LINEAR;
+		VkFilter minFilter = VK_FILTER_LINEAR;
+		VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		float mipLodBias = 0.0f;
+		bool anisotropyEnable = true;
+		float maxAnisotropy = 0.0f;	//0 uses the device limit
+		bool compareEnable = false;
+		VkCompareOp compareOp = VK_COMPARE_OP_ALWAYS;
+		float minLod = 0.0f;
+		float maxLod = VK_LOD_CLAMP_NONE;	//the view already limits the levels that can be sampled
+		VkBorderColor borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		bool unnormalizedCoordinates = false;
+
+		bool operator==(const SamplerDescription& other) const;
+	};
+
+	struct SamplerDescriptionHash {
+		size_t operator()(const SamplerDescription& description) const;
+	};
+
+	//one VkSampler per distinct description for the whole device, samplers live as long as the cache
+	class SamplerCache {
+	public:
+		SamplerCache(VkDevice device, std::shared_ptr<PhysicalDevice> physicalDevice);
+		~SamplerCache();
+		SamplerCache(const SamplerCache&) = delete;
+		SamplerCache(SamplerCache&&) = delete;
+		SamplerCache operator=(const SamplerCache&) = delete;
+		SamplerCache operator=(SamplerCache&&) = delete;
+
+		VkSampler getSampler(const SamplerDescription& description);
+		size_t getSamplerCount() const;
+
+	private:
+		VkDevice device;
+		float maxSamplerAnisotropy;
+		std::unordered_map<SamplerDescription, VkSampler, SamplerDescriptionHash> samplers;
+		mutable std::mutex mutex;
+	};
+}
+
+#endif // !VK_SAMPLER_HPP_
@@ -11,6 +11,7 @@ namespace basicvk {
 	class Shader {
 	public:
 		Shader(std::shared_ptr<Device> device, const std::string &vertexPath, const std::string &fragmentPath);
+		Shader(std::shared_ptr<Device> device, const std::string &computePath);
 		~Shader();
 		Shader(const Shader &other) = delete;
 		Shader(const Shader &&other) = delete;
@@ -19,13 +20,17 @@ namespace basicvk {
 
 		VkShaderModule getVkFragmentShaderModule() const;
 		VkShaderModule getVkVertexShaderModule() const;
+		VkShaderModule getVkComputeShaderModule() const;
+		bool isCompute() const;
 
 		std::array<VkPipelineShaderStageCreateInfo, 2> getPipelineShaderStageCreateInfo() const;
+		VkPipelineShaderStageCreateInfo getComputeShaderStageCreateInfo() const;
 	
 	private:
 		std::shared_ptr<Device> device_ptr;
 		VkShaderModule fragmentShaderModule;
 		VkShaderModule vertexShaderModule;
+		VkShaderModule computeShaderModule;
 	};
 }
 
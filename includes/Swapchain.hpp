@@ -36,6 +36,7 @@ namespace basicvk {
 		VkFormat getVkSwapChainImageFormat() const;
 		VkExtent2D getVkSwapChainExtent() const;
 		const std::vector<VkImageView>& getVkSwapchainImageViews() const;
+		const std::vector<VkImage>& getVkSwapchainImages() const;
 
 	private:
 		std::shared_ptr<Device> device_ptr;
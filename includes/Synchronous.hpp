@@ -3,9 +3,14 @@
 
 #include <vulkan/vulkan.hpp>
 #include <Device.hpp>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace basicvk {
+	class CommandBuffer;
+
 	struct FenceOptions {
 		VkFenceCreateFlags flags = 0;
 	};
@@ -22,6 +27,7 @@ namespace basicvk {
 		VkFence getVkFence() const;
 		void wait(std::uint64_t timeout) const;
 		void reset() const;
+		bool isSignaled() const;
 
 	private:
 		VkFence fence;
@@ -43,6 +49,87 @@ namespace basicvk {
 		VkSemaphore semaphore;
 		std::shared_ptr<Device> device_ptr;
 	};
+
+	//semaphore holding a 64 bit counter, the gpu signals increasing values and the host can poll or wait on any of them
+	class TimelineSemaphore {
+	public:
+		TimelineSemaphore(std::shared_ptr<Device> device, uint64_t initialValue = 0);
+		~TimelineSemaphore();
+		TimelineSemaphore(const TimelineSemaphore&) = delete;
+		TimelineSemaphore(TimelineSemaphore&&) = delete;
+		TimelineSemaphore operator=(const TimelineSemaphore&) = delete;
+		TimelineSemaphore operator=(TimelineSemaphore&&) = delete;
+
+		VkSemaphore getVkSemaphore() const;
+		uint64_t getValue() const;
+		//returns false when the timeout expired first
+		bool wait(uint64_t value, uint64_t timeout) const;
+		void signal(uint64_t value) const;
+
+	private:
+		VkSemaphore semaphore;
+		std::shared_ptr<Device> device_ptr;
+	};
+
+	class QueueTimeline;
+
+	struct SemaphoreWait {
+		const Semaphore* semaphore;
+		VkPipelineStageFlags stageMask;
+	};
+
+	struct TimelineWait {
+		const QueueTimeline* timeline;
+		uint64_t ticket;
+		VkPipelineStageFlags stageMask;
+	};
+
+	//one timeline semaphore per queue, every submission through it signals the next value and returns it as a ticket.
+	//a ticket is complete once the semaphore reached it, 0 is never submitted and always complete.
+	//without DeviceFeatures::timelineSemaphore every submission signals a fence instead, waits on other timelines then
+	//happen on the host before the submission
+	class QueueTimeline {
+	public:
+		QueueTimeline(std::shared_ptr<Device> device, Queue queue);
+		~QueueTimeline();
+		QueueTimeline(const QueueTimeline&) = delete;
+		QueueTimeline(QueueTimeline&&) = delete;
+		QueueTimeline operator=(const QueueTimeline&) = delete;
+		QueueTimeline operator=(QueueTimeline&&) = delete;
+
+		uint64_t submit(const CommandBuffer& commandBuffer, const std::vector<SemaphoreWait>& waitSemaphores = {},
+			const std::vector<const Semaphore*>& signalSemaphores = {}, const std::vector<TimelineWait>& waitTimelines = {});
+		bool isComplete(uint64_t ticket) const;
+		void wait(uint64_t ticket) const;
+		void waitIdle() const;
+
+		uint64_t getLastSubmitted() const;
+		uint64_t getCompleted() const;
+		bool usesFences() const;
+		//only with timeline semaphores
+		const TimelineSemaphore& getSemaphore() const;
+		Queue getQueue() const;
+
+	private:
+		struct PendingFence {
+			uint64_t ticket;
+			VkFence fence;
+		};
+
+		VkFence acquireFence();
+		//moves the fences of completed submissions to freeFences oldest first, without blocking. called with submitMutex held
+		void retireFences() const;
+
+		std::shared_ptr<Device> device_ptr;
+		Queue queue;
+		std::unique_ptr<TimelineSemaphore> semaphore;
+		mutable std::mutex submitMutex;
+		uint64_t lastSubmitted;
+		mutable uint64_t completed;	//fence path only
+		mutable std::deque<PendingFence> pendingFences;
+		mutable std::vector<VkFence> freeFences;	//reset only when reused, a waiter may still hold one
+		mutable uint32_t fenceWaiters;	//threads in vkWaitForFences without the lock, no fence is reused meanwhile
+	};
 }
 
 #endif // !VK_SYNCHRONOUS_HPP_
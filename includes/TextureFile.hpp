@@ -0,0 +1,50 @@
+#ifndef VK_TEXTURE_FILE_HPP_
+#define VK_TEXTURE_FILE_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <string>
+#include <vector>
+
+namespace basicvk {
+	struct TextureFileLevel {
+		uint64_t offset;	//from the start of getData()
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	struct FormatBlockInfo {
+		uint32_t blockWidth;
+		uint32_t blockHeight;
+		uint32_t bytesPerBlock;
+	};
+
+	//2d texture stored with its whole mip chain already baked, read from a KTX2 or DDS container.
+	//supercompressed KTX2, cubemaps, arrays and 3d textures are rejected
+	class TextureFile {
+	public:
+		TextureFile(const std::string& path);
+
+		static bool isTextureFile(const std::string& path);
+		static FormatBlockInfo getFormatBlockInfo(VkFormat format);
+
+		VkFormat getFormat() const;
+		uint32_t getWidth() const;
+		uint32_t getHeight() const;
+		const std::vector<TextureFileLevel>& getLevels() const;
+		const char* getData() const;
+
+	private:
+		void parseKTX2();
+		void parseDDS();
+		void computeLevels(uint64_t dataOffset, uint32_t levelCount);
+
+		std::vector<char> data;
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		std::vector<TextureFileLevel> levels;
+	};
+}
+
+#endif // !VK_TEXTURE_FILE_HPP_
@@ -0,0 +1,108 @@
+#ifndef VK_TEXTURE_LOADER_HPP_
+#define VK_TEXTURE_LOADER_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <Synchronous.hpp>
+#include <ThreadPool.hpp>
+#include <AssetPack.hpp>
+#include <BindlessDescriptors.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace basicvk {
+	struct TextureLoaderOptions {
+		uint32_t workerCount = 0;	//0 uses every hardware thread but one
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		bool useMimaping = true;
+		uint32_t maxTexturesPerBatch = 64;
+		BindlessDescriptors* bindless = nullptr;	//when set, every texture gets a bindless index at load, written once it is ready
+	};
+
+	enum class TextureLoadState {
+		Decoding,
+		Decoded,
+		Uploading,
+		Ready,
+		Failed
+	};
+
+	class StreamedTexture {
+	public:
+		TextureLoadState getState() const;
+		bool isReady() const;
+		bool hasFailed() const;
+		const std::string& getPath() const;
+		const std::string& getError() const;
+		Texture& getTexture() const;
+		//stable from load on, only sampled once the texture is ready. UINT32_MAX without bindless descriptors
+		uint32_t getBindlessIndex() const;
+
+	private:
+		friend class TextureLoader;
+
+		std::string path;
+		std::shared_ptr<AssetPack> pack;	//set when path names an entry of a cooked pack
+		std::string error;
+		std::atomic<TextureLoadState> state{ TextureLoadState::Decoding };
+		std::unique_ptr<Buffer> stagingBuffer;
+		std::unique_ptr<Texture> texture;
+		std::vector<VkBufferImageCopy> copyRegions;	//one per pre-baked level, empty when mips are generated on upload
+		uint32_t bindlessIndex = UINT32_MAX;
+	};
+
+	using TextureHandle = std::shared_ptr<StreamedTexture>;
+
+	//decodes images on worker threads into their own staging buffer,
+	//update() then records the copies and mip generation of every decoded texture into one submission.
+	//ktx2 and dds files keep their block compressed format and baked mip chain, nothing is generated for them.
+	//a handle becomes ready once the timeline reached the ticket of that submission
+	class TextureLoader {
+	public:
+		TextureLoader(std::shared_ptr<Device> device, std::shared_ptr<QueueTimeline> timeline, TextureLoaderOptions options);
+		~TextureLoader();
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader(TextureLoader&&) = delete;
+		TextureLoader operator=(const TextureLoader&) = delete;
+		TextureLoader operator=(TextureLoader&&) = delete;
+
+		TextureHandle load(const std::string& path);
+		TextureHandle load(std::shared_ptr<AssetPack> pack, const std::string& name);
+		uint32_t update();
+		void waitIdle();
+		uint32_t getPendingCount();
+
+	private:
+		struct UploadBatch {
+			std::shared_ptr<CommandBuffer> commandBuffer;
+			uint64_t ticket;
+			std::vector<TextureHandle> textures;
+			bool inFlight;
+		};
+
+		void decode(TextureHandle handle);
+		void decodeImage(StreamedTexture& streamedTexture);
+		void decodeTextureFile(StreamedTexture& streamedTexture);
+		void decodePackedTexture(StreamedTexture& streamedTexture);
+		void checkFormatSupport(VkFormat format) const;
+		void retireBatches();
+		UploadBatch& acquireBatch();
+
+		std::shared_ptr<Device> device_ptr;
+		TextureLoaderOptions options;
+		std::shared_ptr<QueueTimeline> timeline;
+		CommandPool commandPool;
+		std::vector<std::unique_ptr<UploadBatch>> batches;
+		std::mutex decodedMutex;
+		std::vector<TextureHandle> decoded;
+		std::atomic<uint32_t> decodingCount;
+		ThreadPool threadPool;	//declared last so the workers are joined before anything they touch is destroyed
+	};
+}
+
+#endif // !VK_TEXTURE_LOADER_HPP_
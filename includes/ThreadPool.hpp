@@ -0,0 +1,49 @@
+#ifndef VK_THREAD_POOL_HPP_
+#define VK_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace basicvk {
+	//fixed set of worker threads consuming a fifo of jobs,
+	//jobs still queued when the pool is destroyed are dropped
+	class ThreadPool {
+	public:
+		ThreadPool(uint32_t threadCount);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool operator=(const ThreadPool&) = delete;
+		ThreadPool operator=(ThreadPool&&) = delete;
+
+		template<typename F>
+		auto enqueue(F&& task) -> std::future<decltype(task())>
+		{
+			using Result = decltype(task());
+			auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+			std::future<Result> result = packagedTask->get_future();
+			push([packagedTask]() { (*packagedTask)(); });
+			return result;
+		}
+
+		uint32_t getThreadCount() const;
+
+	private:
+		void push(std::function<void()> job);
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping;
+	};
+}
+
+#endif // !VK_THREAD_POOL_HPP_
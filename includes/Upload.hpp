@@ -0,0 +1,77 @@
+#ifndef VK_UPLOAD_HPP_
+#define VK_UPLOAD_HPP_
+
+#include <vulkan/vulkan.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <Synchronous.hpp>
+#include <memory>
+#include <vector>
+
+namespace basicvk {
+	struct UploadManagerOptions {
+		uint64_t stagingBufferSize = 16ull * 1024 * 1024;
+		uint32_t stagingBufferCount = 3;
+		//family of the queue reading the uploaded buffers, ownership is transferred to it when it differs from the upload queue
+		uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	};
+
+	//copies cpu data into GpuOnly buffers through a ring of persistently mapped staging buffers,
+	//every upload recorded between two submit() calls goes out in a single vkQueueSubmit, its ticket is a value of the queue timeline.
+	//on a dedicated transfer queue the copies overlap rendering, the reading queue then has to call acquireOwnership
+	class UploadManager {
+	public:
+		UploadManager(std::shared_ptr<Device> device, std::shared_ptr<QueueTimeline> timeline, UploadManagerOptions options);
+		~UploadManager();
+		UploadManager(const UploadManager&) = delete;
+		UploadManager(UploadManager&&) = delete;
+		UploadManager operator=(const UploadManager&) = delete;
+		UploadManager operator=(UploadManager&&) = delete;
+
+		void uploadBuffer(const Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset = 0);
+		uint64_t submit();
+		bool isComplete(uint64_t ticket) const;
+		void wait(uint64_t ticket) const;
+		//records the acquire half of the ownership transfer of every completed upload, nothing without a transfer
+		void acquireOwnership(const CommandBuffer& commandBuffer,
+			VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkAccessFlags dstAccessMask = VK_ACCESS_MEMORY_READ_BIT);
+
+	private:
+		struct PendingCopy {
+			const Buffer* dst;
+			std::vector<VkBufferCopy> regions;
+		};
+
+		struct ReleasedRange {
+			const Buffer* dst;
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			uint64_t ticket;
+		};
+
+		struct StagingSlot {
+			std::unique_ptr<Buffer> stagingBuffer;
+			std::shared_ptr<CommandBuffer> commandBuffer;
+			std::vector<PendingCopy> pendingCopies;
+			uint64_t used;
+			uint64_t ticket;
+			bool recording;
+		};
+
+		StagingSlot& beginSlot();
+
+		std::shared_ptr<Device> device_ptr;
+		std::shared_ptr<QueueTimeline> timeline;
+		Queue queue;
+		CommandPool commandPool;
+		std::vector<StagingSlot> slots;
+		std::vector<ReleasedRange> releasedRanges;
+		uint32_t dstQueueFamilyIndex;
+		uint64_t stagingBufferSize;
+		uint32_t currentSlot;
+		uint64_t lastTicket;
+	};
+}
+
+#endif // !VK_UPLOAD_HPP_
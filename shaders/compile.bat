@@ -1,4 +1,7 @@
 C:\VulkanSDK\1.3.211.0\Bin\glslc.exe shader.vert -o vert.spv
 C:\VulkanSDK\1.3.211.0\Bin\glslc.exe shader.frag -o frag.spv
+C:\VulkanSDK\1.3.211.0\Bin\glslc.exe downsample.comp -o downsample.spv
+C:\VulkanSDK\1.3.211.0\Bin\glslc.exe hiz.comp -o hiz.spv
+C:\VulkanSDK\1.3.211.0\Bin\glslc.exe cull.comp -o cull.spv
 
 echo shaders compiled successfully
\ No newline at end of file
@@ -0,0 +1,393 @@
+#include <Allocator.hpp>
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace basicvk {
+	struct MemoryBlock {
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		uint32_t memoryTypeIndex;
+		MemoryResourceType resourceType;
+		bool dedicated;
+		VkDeviceSize usedBytes;
+		uint32_t allocationCount;
+		std::map<VkDeviceSize, VkDeviceSize> freeRanges;	//offset -> size, sorted so neighbours can be merged back
+		void* mappedData;
+	};
+
+	static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+	}
+
+	static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment > 1 ? value / alignment * alignment : value;
+	}
+
+	static void* getMappedPointer(const MemoryBlock& block, VkDeviceSize offset)
+	{
+		return block.mappedData != nullptr ? static_cast<char*>(block.mappedData) + offset : nullptr;
+	}
+
+	//best fit over the free ranges of the block, the alignment padding stays in the free list
+	static bool suballocate(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+	{
+		auto best = block.freeRanges.end();
+		VkDeviceSize bestWaste = ~0ull;
+		for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+			VkDeviceSize padding = alignUp(it->first, alignment) - it->first;
+			if (padding + size > it->second) {
+				continue;
+			}
+			VkDeviceSize waste = it->second - size - padding;
+			if (waste < bestWaste) {
+				best = it;
+				bestWaste = waste;
+				if (waste == 0) {
+					break;
+				}
+			}
+		}
+
+		if (best == block.freeRanges.end()) {
+			return false;
+		}
+
+		VkDeviceSize rangeOffset = best->first;
+		VkDeviceSize rangeEnd = best->first + best->second;
+		offset = alignUp(rangeOffset, alignment);
+		block.freeRanges.erase(best);
+		if (offset > rangeOffset) {
+			block.freeRanges[rangeOffset] = offset - rangeOffset;
+		}
+		if (offset + size < rangeEnd) {
+			block.freeRanges[offset + size] = rangeEnd - (offset + size);
+		}
+
+		block.usedBytes += size;
+		block.allocationCount++;
+		return true;
+	}
+
+	static void releaseRange(MemoryBlock& block, VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto next = block.freeRanges.lower_bound(offset);
+		if (next != block.freeRanges.end() && offset + size == next->first) {
+			size += next->second;
+			next = block.freeRanges.erase(next);
+		}
+		if (next != block.freeRanges.begin()) {
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset) {
+				previous->second += size;
+				return;
+			}
+		}
+		block.freeRanges[offset] = size;
+	}
+
+	MemoryAllocator::MemoryAllocator(VkDevice device, std::shared_ptr<PhysicalDevice> physicalDevicePtr, bool bufferDeviceAddress, VkDeviceSize preferredBlockSize)
+		: device(device), physicalDevice(physicalDevicePtr), memoryProperties(), nonCoherentAtomSize(1), preferredBlockSize(preferredBlockSize)
+		, bufferDeviceAddress(bufferDeviceAddress)
+		, blocks(), pendingFlushes(), mutex()
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice->getVkPhysicalDevice(), &memoryProperties);
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice->getVkPhysicalDevice(), &properties);
+		nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+	}
+	MemoryAllocator::~MemoryAllocator()
+	{
+		for (auto& block : blocks) {
+			if (block->mappedData != nullptr) {
+				vkUnmapMemory(device, block->memory);
+			}
+			vkFreeMemory(device, block->memory, nullptr);
+		}
+		blocks.clear();
+	}
+	MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryResourceType resourceType)
+	{
+		return allocateFromType(requirements, physicalDevice->findMemoryType(requirements.memoryTypeBits, properties), resourceType);
+	}
+	MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryResourceType resourceType)
+	{
+		return allocateFromType(requirements, findMemoryType(requirements.memoryTypeBits, usage), resourceType);
+	}
+	MemoryAllocation MemoryAllocator::allocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, MemoryResourceType resourceType)
+	{
+		VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+
+		MemoryAllocation allocation{};
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.size = requirements.size;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		//big resources get their own VkDeviceMemory, they would waste most of a shared block
+		if (requirements.size > blockSize / 2) {
+			MemoryBlock* block = createBlock(memoryTypeIndex, requirements.size, resourceType, true);
+			block->usedBytes = requirements.size;
+			block->allocationCount = 1;
+			allocation.memory = block->memory;
+			allocation.offset = 0;
+			allocation.block = block;
+			allocation.mappedData = getMappedPointer(*block, 0);
+			return allocation;
+		}
+
+		for (auto& block : blocks) {
+			if (block->dedicated || block->memoryTypeIndex != memoryTypeIndex || block->resourceType != resourceType) {
+				continue;
+			}
+			if (suballocate(*block, requirements.size, requirements.alignment, allocation.offset)) {
+				allocation.memory = block->memory;
+				allocation.block = block.get();
+				allocation.mappedData = getMappedPointer(*block, allocation.offset);
+				return allocation;
+			}
+		}
+
+		MemoryBlock* block = createBlock(memoryTypeIndex, blockSize, resourceType, false);
+		if (!suballocate(*block, requirements.size, requirements.alignment, allocation.offset)) {
+			throw std::runtime_error("failed to sub-allocate device memory");
+		}
+		allocation.memory = block->memory;
+		allocation.block = block;
+		allocation.mappedData = getMappedPointer(*block, allocation.offset);
+		return allocation;
+	}
+	void MemoryAllocator::free(MemoryAllocation& allocation)
+	{
+		if (allocation.block == nullptr) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		MemoryBlock* block = allocation.block;
+		block->usedBytes -= allocation.size;
+		block->allocationCount--;
+
+		if (block->dedicated) {
+			destroyBlock(block);
+		}
+		else {
+			releaseRange(*block, allocation.offset, allocation.size);
+
+			//keep a single empty block per memory type around so alloc/free patterns don't thrash vkAllocateMemory
+			if (block->allocationCount == 0) {
+				bool otherEmptyBlock = std::any_of(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& other) {
+					return other.get() != block && !other->dedicated && other->allocationCount == 0
+						&& other->memoryTypeIndex == block->memoryTypeIndex && other->resourceType == block->resourceType;
+				});
+				if (otherEmptyBlock) {
+					destroyBlock(block);
+				}
+			}
+		}
+
+		allocation = MemoryAllocation{};
+	}
+	bool MemoryAllocator::isHostCoherent(const MemoryAllocation& allocation) const
+	{
+		return (memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+	void MemoryAllocator::flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (allocation.block == nullptr || isHostCoherent(allocation)) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		VkMappedMemoryRange range = getMappedRange(allocation, offset, size);
+		pendingFlushes.push_back(range);
+	}
+	void MemoryAllocator::flushMappedRanges()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pendingFlushes.empty()) {
+			return;
+		}
+
+		if (vkFlushMappedMemoryRanges(device, static_cast<uint32_t>(pendingFlushes.size()), pendingFlushes.data()) != VK_SUCCESS) {
+			throw std::runtime_error("unable to flush mapped memory ranges");
+		}
+		pendingFlushes.clear();
+	}
+	void MemoryAllocator::invalidate(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (allocation.block == nullptr || isHostCoherent(allocation)) {
+			return;
+		}
+
+		VkMappedMemoryRange range = getMappedRange(allocation, offset, size);
+		if (vkInvalidateMappedMemoryRanges(device, 1, &range) != VK_SUCCESS) {
+			throw std::runtime_error("unable to invalidate mapped memory range");
+		}
+	}
+	uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, MemoryUsage usage) const
+	{
+		VkMemoryPropertyFlags required = 0;
+		VkMemoryPropertyFlags preferred = 0;
+		VkMemoryPropertyFlags avoided = 0;
+		switch (usage) {
+		case MemoryUsage::Dynamic:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			break;
+		case MemoryUsage::GpuOnly:
+			required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			break;
+		case MemoryUsage::Upload:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			break;
+		case MemoryUsage::Readback:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		}
+
+		auto countBits = [](VkMemoryPropertyFlags flags) -> int {
+			int count = 0;
+			for (; flags != 0; flags &= flags - 1) {
+				count++;
+			}
+			return count;
+		};
+
+		uint32_t bestType = UINT32_MAX;
+		int bestScore = 0;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+			if (!(typeFilter & (1 << i)) || (flags & required) != required) {
+				continue;
+			}
+			int score = countBits(flags & preferred) - countBits(flags & avoided);
+			if (bestType == UINT32_MAX || score > bestScore) {
+				bestType = i;
+				bestScore = score;
+			}
+		}
+
+		if (bestType == UINT32_MAX) {
+			throw std::runtime_error("failed to find suitable memory type!");
+		}
+		return bestType;
+	}
+	MemoryStats MemoryAllocator::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		MemoryStats stats{};
+		VkDeviceSize freeBytes = 0;
+
+		for (const auto& block : blocks) {
+			MemoryBlockStats blockStats{};
+			blockStats.memoryTypeIndex = block->memoryTypeIndex;
+			blockStats.size = block->size;
+			blockStats.usedBytes = block->usedBytes;
+			blockStats.allocationCount = block->allocationCount;
+			blockStats.freeRangeCount = static_cast<uint32_t>(block->freeRanges.size());
+			blockStats.dedicated = block->dedicated;
+			for (const auto& range : block->freeRanges) {
+				blockStats.largestFreeRange = std::max(blockStats.largestFreeRange, range.second);
+				freeBytes += range.second;
+			}
+
+			stats.blockCount++;
+			stats.dedicatedBlockCount += block->dedicated ? 1 : 0;
+			stats.allocationCount += block->allocationCount;
+			stats.reservedBytes += block->size;
+			stats.usedBytes += block->usedBytes;
+			stats.freeRangeCount += blockStats.freeRangeCount;
+			stats.largestFreeRange = std::max(stats.largestFreeRange, blockStats.largestFreeRange);
+			stats.blocks.push_back(blockStats);
+		}
+
+		stats.fragmentation = freeBytes > 0 ? 1.0f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(freeBytes) : 0.0f;
+		return stats;
+	}
+	MemoryBlock* MemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, MemoryResourceType resourceType, bool dedicated)
+	{
+		VkMemoryAllocateInfo memoryAllocateInfo{};
+		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryAllocateInfo.allocationSize = size;
+		memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkMemoryAllocateFlagsInfo allocateFlagsInfo{};
+		allocateFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+		allocateFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+		if (bufferDeviceAddress && resourceType == MemoryResourceType::Linear) {
+			memoryAllocateInfo.pNext = &allocateFlagsInfo;
+		}
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate device memory block");
+		}
+
+		std::unique_ptr<MemoryBlock> block = std::make_unique<MemoryBlock>();
+		block->memory = memory;
+		block->size = size;
+		block->memoryTypeIndex = memoryTypeIndex;
+		block->resourceType = resourceType;
+		block->dedicated = dedicated;
+		block->usedBytes = 0;
+		block->allocationCount = 0;
+		block->mappedData = nullptr;
+		if (!dedicated) {
+			block->freeRanges[0] = size;
+		}
+
+		//host visible blocks are mapped once for their whole lifetime, updates are then plain memcpy
+		if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &block->mappedData) != VK_SUCCESS) {
+				vkFreeMemory(device, memory, nullptr);
+				throw std::runtime_error("unable to map memory");
+			}
+		}
+
+		blocks.push_back(std::move(block));
+		return blocks.back().get();
+	}
+	void MemoryAllocator::destroyBlock(MemoryBlock* block)
+	{
+		if (block->mappedData != nullptr) {
+			vkUnmapMemory(device, block->memory);
+		}
+		vkFreeMemory(device, block->memory, nullptr);
+
+		VkDeviceMemory memory = block->memory;
+		pendingFlushes.erase(std::remove_if(pendingFlushes.begin(), pendingFlushes.end(), [memory](const VkMappedMemoryRange& range) {
+			return range.memory == memory;
+		}), pendingFlushes.end());
+
+		blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& other) {
+			return other.get() == block;
+		}), blocks.end());
+	}
+	VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) const
+	{
+		//small heaps (integrated GPUs, the 256MB BAR window...) are split in eight to keep room for other types
+		uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+		return heapSize <= 1024ull * 1024 * 1024 ? heapSize / 8 : preferredBlockSize;
+	}
+	VkMappedMemoryRange MemoryAllocator::getMappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		//ranges have to be multiples of nonCoherentAtomSize, relative to the start of the VkDeviceMemory
+		VkDeviceSize begin = allocation.offset + offset;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = alignDown(begin, nonCoherentAtomSize);
+		range.size = std::min(alignUp(end, nonCoherentAtomSize), allocation.block->size) - range.offset;
+		return range;
+	}
+}
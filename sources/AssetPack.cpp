@@ -0,0 +1,131 @@
+#include <AssetPack.hpp>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace basicvk {
+	AssetPack::AssetPack(const std::string& path)
+		: mappedData(nullptr), mappedSize(0), fileHandle(nullptr), mappingHandle(nullptr), entries(nullptr), entryCount(0), entryIndices()
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("failed to open asset pack!");
+		}
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(file, &fileSize);
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			CloseHandle(file);
+			throw std::runtime_error("failed to map asset pack!");
+		}
+		mappedData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (mappedData == nullptr) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			throw std::runtime_error("failed to map asset pack!");
+		}
+		fileHandle = file;
+		mappingHandle = mapping;
+		mappedSize = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			throw std::runtime_error("failed to open asset pack!");
+		}
+		struct stat fileStat {};
+		fstat(file, &fileStat);
+		void* mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapping == MAP_FAILED) {
+			close(file);
+			throw std::runtime_error("failed to map asset pack!");
+		}
+		mappedData = static_cast<const char*>(mapping);
+		mappedSize = static_cast<uint64_t>(fileStat.st_size);
+		fileHandle = reinterpret_cast<void*>(static_cast<intptr_t>(file));
+#endif
+
+		AssetPackHeader header{};
+		if (mappedSize < sizeof(header)) {
+			unmap();
+			throw std::runtime_error("asset pack is truncated");
+		}
+		memcpy(&header, mappedData, sizeof(header));
+		//divided rather than multiplied, a corrupt offset or count can't wrap around
+		if (header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION || header.entryOffset > mappedSize
+			|| header.entryCount > (mappedSize - header.entryOffset) / sizeof(AssetPackEntry)) {
+			unmap();
+			throw std::runtime_error("invalid asset pack");
+		}
+
+		entries = reinterpret_cast<const AssetPackEntry*>(mappedData + header.entryOffset);
+		entryCount = header.entryCount;
+		for (uint32_t i = 0; i < entryCount; i++) {
+			const AssetPackEntry& entry = entries[i];
+			entryIndices[std::string(entry.name, strnlen(entry.name, ASSET_PACK_NAME_SIZE))] = i;
+		}
+	}
+	AssetPack::~AssetPack()
+	{
+		unmap();
+	}
+	void AssetPack::unmap()
+	{
+		if (mappedData == nullptr) {
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(mappedData);
+		CloseHandle(static_cast<HANDLE>(mappingHandle));
+		CloseHandle(static_cast<HANDLE>(fileHandle));
+#else
+		munmap(const_cast<char*>(mappedData), static_cast<size_t>(mappedSize));
+		close(static_cast<int>(reinterpret_cast<intptr_t>(fileHandle)));
+#endif
+		mappedData = nullptr;
+	}
+	const AssetPackEntry* AssetPack::find(const std::string& name) const
+	{
+		auto it = entryIndices.find(name);
+		return it != entryIndices.end() ? &entries[it->second] : nullptr;
+	}
+	const AssetPackEntry& AssetPack::getEntry(const std::string& name) const
+	{
+		const AssetPackEntry* entry = find(name);
+		if (entry == nullptr) {
+			throw std::runtime_error("asset not found in pack: " + name);
+		}
+		return *entry;
+	}
+	uint32_t AssetPack::getEntryCount() const
+	{
+		return entryCount;
+	}
+	const AssetPackEntry& AssetPack::getEntry(uint32_t index) const
+	{
+		if (index >= entryCount) {
+			throw std::out_of_range("asset pack entry index is out of range");
+		}
+		return entries[index];
+	}
+	const char* AssetPack::getData(const AssetPackRegion& region) const
+	{
+		validateRegion(region);
+		return mappedData + region.offset;
+	}
+	void AssetPack::validateRegion(const AssetPackRegion& region) const
+	{
+		if (region.offset > mappedSize || region.size > mappedSize - region.offset) {
+			throw std::runtime_error("asset pack region is out of bounds");
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#include <BindlessDescriptors.hpp>
+#include <algorithm>
+#include <cassert>
+
+namespace basicvk {
+	static const VkDescriptorBindingFlags BINDLESS_BINDING_FLAGS = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+
+	uint32_t BindlessDescriptors::IndexAllocator::allocate(const QueueTimeline& timeline)
+	{
+		if (!pending.empty()) {
+			uint64_t completed = timeline.getCompleted();
+			auto retired = std::stable_partition(pending.begin(), pending.end(),
+				[completed](const PendingIndex& entry) { return entry.ticket > completed; });
+			for (auto it = retired; it != pending.end(); it++) {
+				freed.push_back(it->index);
+			}
+			pending.erase(retired, pending.end());
+		}
+		if (!freed.empty()) {
+			uint32_t index = freed.back();
+			freed.pop_back();
+			//an index still waiting on its ticket is never handed out
+			assert(std::none_of(pending.begin(), pending.end(), [index](const PendingIndex& entry) { return entry.index == index; }));
+			return index;
+		}
+		if (next == capacity) {
+			throw std::runtime_error("bindless descriptor array is full");
+		}
+		return next++;
+	}
+	void BindlessDescriptors::IndexAllocator::free(uint32_t index, uint64_t ticket)
+	{
+		if (index >= next) {
+			throw std::invalid_argument("bindless index was not allocated");
+		}
+		assert(std::find(freed.begin(), freed.end(), index) == freed.end());
+		assert(std::none_of(pending.begin(), pending.end(), [index](const PendingIndex& entry) { return entry.index == index; }));
+		if (ticket == 0) {
+			freed.push_back(index);
+			return;
+		}
+		pending.push_back({ index, ticket });
+	}
+
+	BindlessDescriptors::BindlessDescriptors(std::shared_ptr<Device> device, BindlessDescriptorsOptions options)
+		: device_ptr(device), options(clampToLimits(device, options))
+		, descriptorSetLayout(device, {
+			{ SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, this->options.shaderStages, this->options.maxSampledImages, BINDLESS_BINDING_FLAGS },
+			{ SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, this->options.shaderStages, this->options.maxSamplers, BINDLESS_BINDING_FLAGS },
+			{ STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->options.shaderStages, this->options.maxStorageBuffers, BINDLESS_BINDING_FLAGS } })
+		, descriptorPool(device, DescriptorPoolCreateInfo{ {
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, this->options.maxSampledImages },
+			{ VK_DESCRIPTOR_TYPE_SAMPLER, this->options.maxSamplers },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, this->options.maxStorageBuffers } }, 1, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT })
+		, descriptorSet(descriptorPool.allocateDescriptorSet(descriptorSetLayout))
+		, mutex()
+		, images{ this->options.maxSampledImages, 0, {}, {} }
+		, samplers{ this->options.maxSamplers, 0, {}, {} }
+		, buffers{ this->options.maxStorageBuffers, 0, {}, {} }
+		, samplerIndices()
+	{
+		if (!this->options.timeline) {
+			throw std::invalid_argument("bindless descriptors need the timeline of the submissions using them");
+		}
+	}
+	uint32_t BindlessDescriptors::addTexture(const Texture& texture)
+	{
+		uint32_t index = reserveTexture();
+		writeTexture(index, texture);
+		return index;
+	}
+	uint32_t BindlessDescriptors::reserveTexture()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return images.allocate(*options.timeline);
+	}
+	void BindlessDescriptors::writeTexture(uint32_t index, const Texture& texture)
+	{
+		TextureUpdateInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = texture.getVkImageView();
+		imageInfo.sampler = VK_NULL_HANDLE;
+		imageInfo.binding = SAMPLED_IMAGE_BINDING;
+		imageInfo.arrayElement = index;
+		imageInfo.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+
+		DescriptorSetUpdateInfo updateInfo{};
+		updateInfo.textureInfos.push_back(imageInfo);
+		std::lock_guard<std::mutex> lock(mutex);
+		descriptorSet->UpdateDescriptorSet(updateInfo);
+	}
+	void BindlessDescriptors::removeTexture(uint32_t index, uint64_t ticket)
+	{
+		//partially bound, the stale descriptor is simply never indexed again until overwritten
+		std::lock_guard<std::mutex> lock(mutex);
+		images.free(index, ticket);
+	}
+	uint32_t BindlessDescriptors::addSampler(VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = samplerIndices.find(sampler);
+		if (it != samplerIndices.end()) {
+			return it->second;
+		}
+
+		uint32_t index = samplers.allocate(*options.timeline);
+		TextureUpdateInfo samplerInfo{};
+		samplerInfo.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		samplerInfo.imageView = VK_NULL_HANDLE;
+		samplerInfo.sampler = sampler;
+		samplerInfo.binding = SAMPLER_BINDING;
+		samplerInfo.arrayElement = index;
+		samplerInfo.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+
+		DescriptorSetUpdateInfo updateInfo{};
+		updateInfo.textureInfos.push_back(samplerInfo);
+		descriptorSet->UpdateDescriptorSet(updateInfo);
+		samplerIndices[sampler] = index;
+		return index;
+	}
+	uint32_t BindlessDescriptors::addBuffer(const Buffer& buffer, uint64_t offset, uint64_t range)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		uint32_t index = buffers.allocate(*options.timeline);
+
+		BufferUpdateInfo bufferInfo{};
+		bufferInfo.buffer = buffer.getVkBuffer();
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+		bufferInfo.binding = STORAGE_BUFFER_BINDING;
+		bufferInfo.arrayElement = index;
+		bufferInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+		DescriptorSetUpdateInfo updateInfo{};
+		updateInfo.bufferInfos.push_back(bufferInfo);
+		descriptorSet->UpdateDescriptorSet(updateInfo);
+		return index;
+	}
+	void BindlessDescriptors::removeBuffer(uint32_t index, uint64_t ticket)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		buffers.free(index, ticket);
+	}
+	const DescriptorSetLayout& BindlessDescriptors::getDescriptorSetLayout() const
+	{
+		return descriptorSetLayout;
+	}
+	std::shared_ptr<DescriptorSet> BindlessDescriptors::getDescriptorSet() const
+	{
+		return descriptorSet;
+	}
+	BindlessDescriptorsOptions BindlessDescriptors::clampToLimits(std::shared_ptr<Device> device, BindlessDescriptorsOptions options)
+	{
+		//checked before anything is created with the binding flags
+		if (!device->getFeatures().descriptorIndexing) {
+			throw std::runtime_error("descriptor indexing is not supported by the device");
+		}
+
+		VkPhysicalDeviceVulkan12Properties properties12{};
+		properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &properties12;
+		vkGetPhysicalDeviceProperties2(device->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
+
+		//every stage may see every array, so the per stage limits apply to each of them
+		options.maxSampledImages = std::min({ options.maxSampledImages, properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+			properties12.maxPerStageDescriptorUpdateAfterBindSampledImages });
+		options.maxSamplers = std::min({ options.maxSamplers, properties12.maxDescriptorSetUpdateAfterBindSamplers,
+			properties12.maxPerStageDescriptorUpdateAfterBindSamplers });
+		options.maxStorageBuffers = std::min({ options.maxStorageBuffers, properties12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+			properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+		return options;
+	}
+}
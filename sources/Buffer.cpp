@@ -2,9 +2,40 @@
 #include <cassert>
 
 namespace basicvk {
+	static uint32_t getMipLevelCount(const TextureOptions& options)
+	{
+		if (options.mipLevels != 0) {
+			return options.mipLevels;
+		}
+		else if (options.useMimaping) {
+			return static_cast<uint32_t>(std::floor(std::log2((options.width > options.height) ? options.width : options.height)));
+		}
+		return 1;
+	}
+
+	static VkImageCreateInfo getImageCreateInfo(const TextureOptions& options, uint32_t mipLevels)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.flags = options.flags;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = options.width;
+		imageInfo.extent.height = options.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = options.format;
+		imageInfo.tiling = options.tiling;
+		imageInfo.initialLayout = options.imageLayout;
+		imageInfo.usage = options.usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		return imageInfo;
+	}
+
 	Buffer::Buffer(std::shared_ptr<Device> devicePtr, BufferOptions options, uint64_t size)
-		: buffer(VK_NULL_HANDLE), bufferMemory(VK_NULL_HANDLE),
-		bufferSize(size), device_ptr(devicePtr)
+		: buffer(VK_NULL_HANDLE), allocation(),
+		bufferSize(size), resourceState(), device_ptr(devicePtr)
 	{
 		VkBufferCreateInfo bufferCreateInfo{};
 		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -17,27 +48,12 @@ namespace basicvk {
 			throw std::runtime_error("failed to create the buffer");
 		}
 
-		std::shared_ptr<PhysicalDevice> physicalDevice = device_ptr->getPhysicalDevice();
-		VkPhysicalDeviceMemoryProperties memoryProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice->getVkPhysicalDevice(), &memoryProperties);
-
 		VkMemoryRequirements memoryRequirements;
 		vkGetBufferMemoryRequirements(device_ptr->getVkDevice(), buffer, &memoryRequirements);
 
-		auto properties = (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		uint32_t memoryTypeIndex = physicalDevice->findMemoryType(memoryRequirements.memoryTypeBits, properties);
-
-		VkMemoryAllocateInfo memoryAllocateInfo{};
-		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memoryAllocateInfo.allocationSize = memoryRequirements.size;
-		memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+		allocation = device_ptr->getMemoryAllocator().allocate(memoryRequirements, options.memoryUsage, MemoryResourceType::Linear);
 
-		if (vkAllocateMemory(device_ptr->getVkDevice(), &memoryAllocateInfo, nullptr, &bufferMemory) != VK_SUCCESS) 
-		{
-			throw std::runtime_error("failed to allocate memory to the buffer");
-		}
-
-		if (vkBindBufferMemory(device_ptr->getVkDevice(), buffer, bufferMemory, 0) != VK_SUCCESS)
+		if (vkBindBufferMemory(device_ptr->getVkDevice(), buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to bind memory to the buffer");
 		}
@@ -48,9 +64,8 @@ namespace basicvk {
 			vkDestroyBuffer(device_ptr->getVkDevice(), buffer, nullptr);
 			buffer = VK_NULL_HANDLE;
 		}
-		if (bufferMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(device_ptr->getVkDevice(), bufferMemory, nullptr);
-			bufferMemory = VK_NULL_HANDLE;
+		if (allocation.memory != VK_NULL_HANDLE) {
+			device_ptr->getMemoryAllocator().free(allocation);
 		}
 	}
 	uint64_t Buffer::getBufferSize() const
@@ -63,30 +78,41 @@ namespace basicvk {
 	}
 	void Buffer::mapMemory(void* data, uint64_t size)
 	{
-		assert(size <= this->bufferSize);
-		void* dest;
-		VkResult result = vkMapMemory(device_ptr->getVkDevice(), bufferMemory, 0, size, 0, &dest);
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error("unable to map memory");
+		write(data, size, 0);
+	}
+	void Buffer::write(const void* data, uint64_t size, uint64_t offset)
+	{
+		assert(offset + size <= this->bufferSize);
+		if (allocation.mappedData == nullptr) {
+			throw std::runtime_error("buffer memory is not host visible");
 		}
 
-		memcpy(dest, data, static_cast<size_t>(size));
-		vkUnmapMemory(device_ptr->getVkDevice(), bufferMemory);
+		memcpy(static_cast<char*>(allocation.mappedData) + offset, data, static_cast<size_t>(size));
+		flush(offset, size);
+	}
+	void Buffer::flush(uint64_t offset, uint64_t size)
+	{
+		//only queued here, MemoryAllocator::flushMappedRanges submits every pending range in one call
+		device_ptr->getMemoryAllocator().flush(allocation, offset, size);
+	}
+	void Buffer::invalidate(uint64_t offset, uint64_t size)
+	{
+		device_ptr->getMemoryAllocator().invalidate(allocation, offset, size);
 	}
 	Buffer::Buffer(Buffer& other) 
 		: device_ptr(other.device_ptr), buffer(other.buffer),
-		bufferSize(other.bufferSize), bufferMemory(other.bufferMemory)
+		bufferSize(other.bufferSize), allocation(other.allocation), resourceState(other.resourceState)
 	{
 		other.buffer = VK_NULL_HANDLE;		
-		other.bufferMemory = VK_NULL_HANDLE;
+		other.allocation = MemoryAllocation{};
 		other.bufferSize = 0;
 	}
 	Buffer::Buffer(Buffer&& other) noexcept
 		: device_ptr(other.device_ptr), buffer(other.buffer),
-		bufferSize(other.bufferSize), bufferMemory(other.bufferMemory)
+		bufferSize(other.bufferSize), allocation(other.allocation), resourceState(other.resourceState)
 	{
 		other.buffer = VK_NULL_HANDLE;
-		other.bufferMemory = VK_NULL_HANDLE;
+		other.allocation = MemoryAllocation{};
 		other.bufferSize = 0;
 	}
 	Buffer Buffer::operator=(Buffer& other)
@@ -99,34 +125,40 @@ namespace basicvk {
 	}
 	VkDeviceMemory Buffer::getBufferMemory() const
 	{
-		return bufferMemory;
+		return allocation.memory;
+	}
+	VkDeviceSize Buffer::getMemoryOffset() const
+	{
+		return allocation.offset;
+	}
+	void* Buffer::getMappedData() const
+	{
+		return allocation.mappedData;
+	}
+	VkDeviceAddress Buffer::getDeviceAddress() const
+	{
+		VkBufferDeviceAddressInfo addressInfo{};
+		addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+		addressInfo.buffer = buffer;
+		return vkGetBufferDeviceAddress(device_ptr->getVkDevice(), &addressInfo);
+	}
+	ResourceState& Buffer::getResourceState() const
+	{
+		return resourceState;
 	}
 
 
 	Texture::Texture(std::shared_ptr<Device> devicePtr, TextureOptions options)
-		: image(VK_NULL_HANDLE), imageMemory(VK_NULL_HANDLE), imageView(VK_NULL_HANDLE), sampler(VK_NULL_HANDLE)
-		, format(options.format), imageLayout(options.imageLayout), width(options.width), height(options.height), device_ptr(devicePtr)
+		: image(VK_NULL_HANDLE), allocation(), imageView(VK_NULL_HANDLE), sampler(VK_NULL_HANDLE)
+		, format(options.format), subresourceStates(), width(options.width), height(options.height), device_ptr(devicePtr)
 		, mipLevels(1)
 	{
-		if (options.useMimaping) {
-			mipLevels = static_cast<uint32_t>(std::floor(std::log2( (width > height) ? width : height)));
-		}
-
-		VkImageCreateInfo imageInfo{};
-		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.extent.width = width;
-		imageInfo.extent.height = height;
-		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = mipLevels;
-		imageInfo.arrayLayers = 1;
-		imageInfo.format = options.format;
-		imageInfo.tiling = options.tiling;
-		imageInfo.initialLayout = imageLayout;
-		imageInfo.usage = options.usage;
-		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		mipLevels = getMipLevelCount(options);
+		ResourceState initialState{};
+		initialState.layout = options.imageLayout;
+		subresourceStates.assign(mipLevels, initialState);
 
+		VkImageCreateInfo imageInfo = getImageCreateInfo(options, mipLevels);
 		if (vkCreateImage(device_ptr->getVkDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
@@ -134,23 +166,26 @@ namespace basicvk {
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(device_ptr->getVkDevice(), image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = device_ptr->getPhysicalDevice()->findMemoryType(memRequirements.memoryTypeBits, options.properties);
-
-		if (vkAllocateMemory(device_ptr->getVkDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
+		if (options.aliasedMemory != nullptr) {
+			//without a block the allocation is not freed with the texture
+			allocation = *options.aliasedMemory;
+			allocation.block = nullptr;
+		}
+		else {
+			MemoryResourceType resourceType = options.tiling == VK_IMAGE_TILING_OPTIMAL ? MemoryResourceType::Optimal : MemoryResourceType::Linear;
+			allocation = device_ptr->getMemoryAllocator().allocate(memRequirements, options.properties, resourceType);
 		}
 
-		vkBindImageMemory(device_ptr->getVkDevice(), image, imageMemory, 0);
+		if (vkBindImageMemory(device_ptr->getVkDevice(), image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+			throw std::runtime_error("failed to bind image memory!");
+		}
 
 		VkImageViewCreateInfo viewInfo{};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = image;
 		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
-		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.format = options.format;
+		viewInfo.subresourceRange.aspectMask = getImageViewAspectMask(options.format);
 		viewInfo.subresourceRange.baseMipLevel = 0;
 		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
@@ -160,29 +195,22 @@ namespace basicvk {
 			throw std::runtime_error("failed to create texture image view!");
 		}
 
-		VkPhysicalDeviceProperties properties{};
-		vkGetPhysicalDeviceProperties(device_ptr->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
-		VkSamplerCreateInfo samplerInfo{};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
-		samplerInfo.compareEnable = VK_FALSE;
-		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;
-		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = static_cast<float>(mipLevels);
-
-		if (vkCreateSampler(device_ptr->getVkDevice(), &samplerInfo, VK_NULL_HANDLE, &sampler) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create texture sampler!");
+		//shared with every texture using the same description, owned by the device
+		sampler = device_ptr->getSamplerCache().getSampler(options.sampler);
+	}
+	VkMemoryRequirements Texture::getMemoryRequirements(std::shared_ptr<Device> devicePtr, const TextureOptions& options)
+	{
+		//a probe image, the requirements only depend on its create info
+		VkImageCreateInfo imageInfo = getImageCreateInfo(options, getMipLevelCount(options));
+		VkImage image;
+		if (vkCreateImage(devicePtr->getVkDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create image!");
 		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(devicePtr->getVkDevice(), image, &memRequirements);
+		vkDestroyImage(devicePtr->getVkDevice(), image, VK_NULL_HANDLE);
+		return memRequirements;
 	}
 	Texture::~Texture()
 	{
@@ -190,26 +218,22 @@ namespace basicvk {
 			vkDestroyImage(device_ptr->getVkDevice(), image, VK_NULL_HANDLE);
 			image = VK_NULL_HANDLE;
 		}
-		if (imageMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(device_ptr->getVkDevice(), imageMemory, VK_NULL_HANDLE);
-			imageMemory = VK_NULL_HANDLE;
+		if (allocation.memory != VK_NULL_HANDLE) {
+			device_ptr->getMemoryAllocator().free(allocation);
 		}
 		if (imageView != VK_NULL_HANDLE) {
 			vkDestroyImageView(device_ptr->getVkDevice(), imageView, VK_NULL_HANDLE);
 			imageView = VK_NULL_HANDLE;
 		}
-		if (sampler != VK_NULL_HANDLE) {
-			vkDestroySampler(device_ptr->getVkDevice(), sampler, VK_NULL_HANDLE);
-			sampler = VK_NULL_HANDLE;
-		}
+		sampler = VK_NULL_HANDLE;
 	}
 	Texture::Texture(Texture& other)
-		: image(other.image), imageMemory(other.imageMemory), imageView(other.imageView), sampler(other.sampler)
-		, width(other.width), height(other.height), format(other.format), imageLayout(other.imageLayout)
+		: image(other.image), allocation(other.allocation), imageView(other.imageView), sampler(other.sampler)
+		, width(other.width), height(other.height), format(other.format), subresourceStates(other.subresourceStates)
 		, mipLevels(other.mipLevels), device_ptr(other.device_ptr)
 	{
 		other.image = VK_NULL_HANDLE;
-		other.imageMemory = VK_NULL_HANDLE;
+		other.allocation = MemoryAllocation{};
 		other.imageView = VK_NULL_HANDLE;
 		other.sampler = VK_NULL_HANDLE;
 		other.width = 0;
@@ -220,12 +244,12 @@ namespace basicvk {
 		return Texture(other);
 	}
 	Texture::Texture(Texture&& other) noexcept
-		: image(other.image), imageMemory(other.imageMemory), imageView(other.imageView), sampler(other.sampler)
-		, width(other.width), height(other.height), format(other.format), imageLayout(other.imageLayout)
+		: image(other.image), allocation(other.allocation), imageView(other.imageView), sampler(other.sampler)
+		, width(other.width), height(other.height), format(other.format), subresourceStates(other.subresourceStates)
 		, mipLevels(other.mipLevels), device_ptr(other.device_ptr)
 	{
 		other.image = VK_NULL_HANDLE;
-		other.imageMemory = VK_NULL_HANDLE;
+		other.allocation = MemoryAllocation{};
 		other.imageView = VK_NULL_HANDLE;
 		other.sampler = VK_NULL_HANDLE;
 		other.width = 0;
@@ -241,7 +265,11 @@ namespace basicvk {
 	}
 	VkDeviceMemory Texture::getVkImageMemory() const
 	{
-		return imageMemory;
+		return allocation.memory;
+	}
+	VkDeviceSize Texture::getMemoryOffset() const
+	{
+		return allocation.offset;
 	}
 	VkImageView Texture::getVkImageView() const
 	{
@@ -269,10 +297,14 @@ namespace basicvk {
 	}
 	VkImageLayout Texture::getVkImageLayout() const
 	{
-		return imageLayout;
+		return subresourceStates.empty() ? VK_IMAGE_LAYOUT_UNDEFINED : subresourceStates[0].layout;
 	}
 	void Texture::setVkImageLayout(VkImageLayout imageLayout)
 	{
-		this->imageLayout = imageLayout;
+		subresourceStates.assign(mipLevels, getUnknownState(imageLayout));
+	}
+	ResourceState& Texture::getResourceState(uint32_t mipLevel)
+	{
+		return subresourceStates.at(mipLevel);
 	}
 }
\ No newline at end of file
@@ -1,12 +1,13 @@
 #include "Command.hpp"
+#include <DescriptorBuffer.hpp>
 
 namespace basicvk {
-	CommandPool::CommandPool(std::shared_ptr<Device> device, Queue queue)
-		: commandBuffers(), commandPool(VK_NULL_HANDLE), device_ptr(device), queue(queue)
+	CommandPool::CommandPool(std::shared_ptr<Device> device, Queue queue, VkCommandPoolCreateFlags flags)
+		: commandBuffers(), recycledCommandBuffers(), commandPool(VK_NULL_HANDLE), device_ptr(device), queue(queue)
 	{
 		VkCommandPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.flags = flags;
 		poolInfo.queueFamilyIndex = queue.getQueueFamilyIndex();
 		poolInfo.pNext = nullptr;
 
@@ -22,18 +23,19 @@ namespace basicvk {
 		}
 	}
 	CommandPool::CommandPool(CommandPool& other)
-		: commandBuffers(other.commandBuffers), commandPool(other.commandPool), device_ptr(other.device_ptr), queue(other.queue)
+		: commandBuffers(other.commandBuffers), recycledCommandBuffers(other.recycledCommandBuffers), commandPool(other.commandPool), device_ptr(other.device_ptr), queue(other.queue)
 	{
 		other.commandBuffers.clear();
+		other.recycledCommandBuffers = {};
 		other.commandPool = VK_NULL_HANDLE;
 	}
 	CommandPool CommandPool::operator=(CommandPool& commandPool)
 	{
 		return CommandPool(commandPool);
 	}
-	std::shared_ptr<CommandBuffer> CommandPool::allocateCommandBuffer()
+	std::shared_ptr<CommandBuffer> CommandPool::allocateCommandBuffer(VkCommandBufferLevel level)
 	{
-		std::shared_ptr<CommandBuffer> commandBuffer = std::make_shared<CommandBuffer>(device_ptr, commandPool, queue);
+		std::shared_ptr<CommandBuffer> commandBuffer = std::make_shared<CommandBuffer>(device_ptr, commandPool, queue, level);
 		commandBuffers.push_back(commandBuffer);
 		return commandBuffer;
 
@@ -42,13 +44,62 @@ namespace basicvk {
 	{
 		return commandBuffers;
 	}
-	CommandBuffer::CommandBuffer(std::shared_ptr<Device> device, VkCommandPool vkCommandPool, Queue queue)
-		: commandBuffer(VK_NULL_HANDLE), device_ptr(device), queue(queue)
+	std::shared_ptr<CommandBuffer> CommandPool::acquireCommandBuffer(VkCommandBufferLevel level)
+	{
+		RecycledCommandBuffers& recycled = recycledCommandBuffers[level];
+		if (recycled.used == recycled.commandBuffers.size()) {
+			recycled.commandBuffers.push_back(std::make_shared<CommandBuffer>(device_ptr, commandPool, queue, level));
+		}
+		return recycled.commandBuffers[recycled.used++];
+	}
+	void CommandPool::reset()
+	{
+		if (vkResetCommandPool(device_ptr->getVkDevice(), commandPool, 0) != VK_SUCCESS) {
+			throw std::runtime_error("unable to reset command pool");
+		}
+		for (auto& recycled : recycledCommandBuffers) {
+			recycled.used = 0;
+		}
+	}
+	CommandPoolRing::CommandPoolRing(std::shared_ptr<Device> device, Queue queue, uint32_t frameCount)
+		: commandPools(), currentFrame(0)
+	{
+		if (frameCount == 0) {
+			throw std::invalid_argument("command pool ring needs at least one frame");
+		}
+		for (uint32_t i = 0; i < frameCount; i++) {
+			commandPools.push_back(std::make_unique<CommandPool>(device, queue, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT));
+		}
+	}
+	void CommandPoolRing::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex % static_cast<uint32_t>(commandPools.size());
+		commandPools[currentFrame]->reset();
+	}
+	std::shared_ptr<CommandBuffer> CommandPoolRing::acquireCommandBuffer(VkCommandBufferLevel level)
+	{
+		return commandPools[currentFrame]->acquireCommandBuffer(level);
+	}
+	CommandPool& CommandPoolRing::getCommandPool(uint32_t frameIndex) const
+	{
+		return *commandPools[frameIndex % commandPools.size()];
+	}
+	uint32_t CommandPoolRing::getFrameCount() const
+	{
+		return static_cast<uint32_t>(commandPools.size());
+	}
+	uint64_t CommandBufferStats::getElidedCommandCount() const
+	{
+		return elidedPipelineBinds + elidedVertexBufferBinds + elidedIndexBufferBinds
+			+ elidedDescriptorSetBinds + elidedViewports + elidedScissors;
+	}
+	CommandBuffer::CommandBuffer(std::shared_ptr<Device> device, VkCommandPool vkCommandPool, Queue queue, VkCommandBufferLevel level)
+		: commandBuffer(VK_NULL_HANDLE), device_ptr(device), queue(queue), level(level), boundState(), stats(), pendingBarriers()
 	{
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = vkCommandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.level = level;
 		allocInfo.commandBufferCount = 1;
 
 		if (vkAllocateCommandBuffers(device->getVkDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
@@ -56,7 +107,8 @@ namespace basicvk {
 		}
 	}
 	CommandBuffer::CommandBuffer(CommandBuffer& other)
-		: commandBuffer(other.commandBuffer), device_ptr(other.device_ptr)
+		: commandBuffer(other.commandBuffer), device_ptr(other.device_ptr), queue(other.queue), level(other.level), boundState(other.boundState), stats(other.stats)
+		, pendingBarriers(other.pendingBarriers)
 	{
 		other.commandBuffer = VK_NULL_HANDLE;
 	}
@@ -71,6 +123,10 @@ namespace basicvk {
 	{
 		return commandBuffer;
 	}
+	VkCommandBufferLevel CommandBuffer::getLevel() const
+	{
+		return level;
+	}
 	void CommandBuffer::beginCommandBuffer(CommandBufferUsage info) const
 	{
 		VkCommandBufferBeginInfo beginInfo{};
@@ -81,9 +137,43 @@ namespace basicvk {
 		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
 			throw std::runtime_error("failed to begin recording command buffer!");
 		}
+		invalidateState();
+	}
+	void CommandBuffer::beginCommandBuffer(CommandBufferUsage info, const CommandBufferInheritance& inheritance) const
+	{
+		if (level != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+			throw std::invalid_argument("only secondary command buffers inherit a render pass");
+		}
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = inheritance.renderPass;
+		inheritanceInfo.subpass = inheritance.subpass;
+		inheritanceInfo.framebuffer = inheritance.framebuffer;
+
+		VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(inheritance.colorAttachmentFormats.size());
+		renderingInfo.pColorAttachmentFormats = inheritance.colorAttachmentFormats.data();
+		renderingInfo.depthAttachmentFormat = inheritance.depthAttachmentFormat;
+		renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		if (inheritance.renderPass == VK_NULL_HANDLE) {
+			inheritanceInfo.pNext = &renderingInfo;
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = info.usage | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		invalidateState();
 	}
 	void CommandBuffer::endCommandBuffer() const
 	{
+		flushBarriers();
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to end command buffer!");
 		}
@@ -101,8 +191,14 @@ namespace basicvk {
 		bufferCopyInfo.srcOffset = 0;
 		bufferCopyInfo.size = src.getBufferSize() <= dst.getBufferSize() ? src.getBufferSize() : dst.getBufferSize();
 		
+		flushBarriers();
 		vkCmdCopyBuffer(commandBuffer, src.getVkBuffer(), dst.getVkBuffer(), 1, &bufferCopyInfo);
 	}
+	void CommandBuffer::CopyBuffer(const Buffer& src, const Buffer& dst, const std::vector<VkBufferCopy>& regions) const
+	{
+		flushBarriers();
+		vkCmdCopyBuffer(commandBuffer, src.getVkBuffer(), dst.getVkBuffer(), static_cast<uint32_t>(regions.size()), regions.data());
+	}
 	void CommandBuffer::CopyBufferToTexture(const Buffer& src, const Texture& dest) const
 	{
 		VkBufferImageCopy region{};
@@ -122,6 +218,7 @@ namespace basicvk {
 			1
 		};
 
+		flushBarriers();
 		vkCmdCopyBufferToImage(commandBuffer,
 			src.getVkBuffer(),
 			dest.getVkImage(),
@@ -129,84 +226,43 @@ namespace basicvk {
 			1,
 			&region);
 	}
+	void CommandBuffer::CopyBufferToTexture(const Buffer& src, const Texture& dest, const std::vector<VkBufferImageCopy>& regions) const
+	{
+		flushBarriers();
+		vkCmdCopyBufferToImage(commandBuffer,
+			src.getVkBuffer(),
+			dest.getVkImage(),
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()),
+			regions.data());
+	}
 	void CommandBuffer::transitionImageLayout(Texture& texture, VkFormat format, VkImageLayout newLayout) const
 	{
-		VkImageLayout oldLayout = texture.getVkImageLayout();
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = texture.getVkImage();
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = texture.getMipLevels();
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-		
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
-
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		ResourceAccess access;
+		switch (newLayout) {
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: access = ResourceAccess::TransferWrite; break;
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: access = ResourceAccess::TransferRead; break;
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: access = ResourceAccess::FragmentSampledRead; break;
+		case VK_IMAGE_LAYOUT_GENERAL: access = ResourceAccess::ComputeStorageReadWrite; break;
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: access = ResourceAccess::ColorAttachmentWrite; break;
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: access = ResourceAccess::DepthAttachmentWrite; break;
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: access = ResourceAccess::DepthAttachmentRead; break;
+		case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: access = ResourceAccess::Present; break;
+		default: throw std::invalid_argument("unsupported layout transition!");
 		}
-		else {
-			throw std::invalid_argument("unsupported layout transition!");
-		}
-
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage,
-			destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
-
-		texture.setVkImageLayout(newLayout);
+		requireAccess(texture, access);
 	}
 	void CommandBuffer::generateMipMap(Texture& texture) const
 	{
 		VkImage vkImage = texture.getVkImage();
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.image = vkImage;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-		barrier.subresourceRange.levelCount = 1;
-
 		int32_t mipWidth = texture.getWidth();
 		int32_t mipHeight = texture.getHeight();
 		uint32_t mipLevels = texture.getMipLevels();
 
 		for (uint32_t i = 1; i < mipLevels; i++) {
-			barrier.subresourceRange.baseMipLevel = i - 1;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
+			requireAccess(texture, ResourceAccess::TransferRead, i - 1, 1);
+			requireAccess(texture, ResourceAccess::TransferWrite, i, 1);
+			flushBarriers();
 
 			VkImageBlit blit{};
 			blit.srcOffsets[0] = { 0, 0, 0 };
@@ -228,36 +284,15 @@ namespace basicvk {
 				1, &blit,
 				VK_FILTER_LINEAR);
 
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
-
 			if (mipWidth > 1) mipWidth /= 2;
 			if (mipHeight > 1) mipHeight /= 2;
 		}
 
-		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		vkCmdPipelineBarrier(commandBuffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier);
-
-		texture.setVkImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		//the whole chain moves to the shaders with a single barrier, recorded with whatever comes next
+		requireAccess(texture, ResourceAccess::FragmentSampledRead);
 	}
-	void CommandBuffer::beginRenderPass(const GraphicPipeline &graphicPipeline, const Swapchain& swapchain, const Framebuffer &frameBuffer, uint32_t indexImage) const
+	void CommandBuffer::beginRenderPass(const GraphicPipeline &graphicPipeline, const Swapchain& swapchain, const Framebuffer &frameBuffer, uint32_t indexImage,
+		VkSubpassContents contents) const
 	{
 		VkRenderPassBeginInfo renderPassBeginInfo{};
 		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -272,68 +307,531 @@ namespace basicvk {
 		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassBeginInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		flushBarriers();
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, contents);
 	}
 	void CommandBuffer::endRenderPass() const
 	{
 		vkCmdEndRenderPass(commandBuffer);
 	}
+	static VkRenderingAttachmentInfo getRenderingAttachmentInfo(const RenderingAttachment& attachment)
+	{
+		VkRenderingAttachmentInfo attachmentInfo{};
+		attachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		attachmentInfo.imageView = attachment.imageView;
+		attachmentInfo.imageLayout = attachment.imageLayout;
+		attachmentInfo.resolveMode = VK_RESOLVE_MODE_NONE;
+		attachmentInfo.loadOp = attachment.loadOp;
+		attachmentInfo.storeOp = attachment.storeOp;
+		attachmentInfo.clearValue = attachment.clearValue;
+		return attachmentInfo;
+	}
+	static VkImageMemoryBarrier2 getAttachmentBarrier(VkImage image, VkImageAspectFlags aspectMask, VkPipelineStageFlags2 srcStageMask, VkAccessFlags2 srcAccessMask,
+		VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask, VkImageLayout oldLayout, VkImageLayout newLayout)
+	{
+		VkImageMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = srcStageMask;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstStageMask = dstStageMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { aspectMask, 0, 1, 0, 1 };
+		return barrier;
+	}
+	void CommandBuffer::beginRendering(VkExtent2D extent, const std::vector<RenderingAttachment>& colorAttachments, const RenderingAttachment* depthAttachment,
+		VkRenderingFlags flags, const RenderingAttachment* stencilAttachment) const
+	{
+		std::vector<VkRenderingAttachmentInfo> colorInfos;
+		colorInfos.reserve(colorAttachments.size());
+		for (const auto& attachment : colorAttachments) {
+			colorInfos.push_back(getRenderingAttachmentInfo(attachment));
+		}
+		VkRenderingAttachmentInfo depthInfo{};
+		if (depthAttachment != nullptr) {
+			depthInfo = getRenderingAttachmentInfo(*depthAttachment);
+		}
+		VkRenderingAttachmentInfo stencilInfo{};
+		if (stencilAttachment != nullptr) {
+			stencilInfo = getRenderingAttachmentInfo(*stencilAttachment);
+		}
+
+		VkRenderingInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+		renderingInfo.flags = flags;
+		renderingInfo.renderArea.offset = { 0, 0 };
+		renderingInfo.renderArea.extent = extent;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorInfos.size());
+		renderingInfo.pColorAttachments = colorInfos.data();
+		renderingInfo.pDepthAttachment = depthAttachment != nullptr ? &depthInfo : nullptr;
+		renderingInfo.pStencilAttachment = stencilAttachment != nullptr ? &stencilInfo : nullptr;
+
+		flushBarriers();
+		vkCmdBeginRendering(commandBuffer, &renderingInfo);
+	}
+	void CommandBuffer::beginRendering(const GraphicPipeline& graphicPipeline, const Swapchain& swapchain, uint32_t indexImage, VkRenderingFlags flags) const
+	{
+		//what the subpass dependency and the initial layouts of the render pass did, both images are cleared so their content is dropped.
+		//the color barrier chains on the stage the image acquire semaphore is waited at
+		DepthBuffer depthBuffer = graphicPipeline.getDepthBuffer();
+		pendingBarriers.imageBarriers.push_back(getAttachmentBarrier(swapchain.getVkSwapchainImages()[indexImage], VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+		pendingBarriers.imageBarriers.push_back(getAttachmentBarrier(depthBuffer.depthImage, getImageAspectMask(graphicPipeline.getDepthFormat()),
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL));
+
+		RenderingAttachment colorAttachment{};
+		colorAttachment.imageView = swapchain.getVkSwapchainImageViews()[indexImage];
+		colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.clearValue.color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+
+		RenderingAttachment depthAttachment{};
+		depthAttachment.imageView = depthBuffer.depthImageView;
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.storeOp = graphicPipeline.getDepthStoreOp();
+		depthAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+		//the pipeline declares a stencil format for depth stencil formats, the same view is given for it like the render pass does
+		if (getImageAspectMask(graphicPipeline.getDepthFormat()) & VK_IMAGE_ASPECT_STENCIL_BIT) {
+			RenderingAttachment stencilAttachment = depthAttachment;
+			stencilAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			beginRendering(swapchain.getVkSwapChainExtent(), { colorAttachment }, &depthAttachment, flags, &stencilAttachment);
+			return;
+		}
+		beginRendering(swapchain.getVkSwapChainExtent(), { colorAttachment }, &depthAttachment, flags);
+	}
+	void CommandBuffer::endRendering() const
+	{
+		vkCmdEndRendering(commandBuffer);
+	}
+	void CommandBuffer::endRendering(const Swapchain& swapchain, uint32_t indexImage) const
+	{
+		vkCmdEndRendering(commandBuffer);
+		//the present semaphore is signaled once every stage is done, nothing has to wait on the barrier
+		pendingBarriers.imageBarriers.push_back(getAttachmentBarrier(swapchain.getVkSwapchainImages()[indexImage], VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR));
+	}
+	void CommandBuffer::executeCommands(const std::vector<std::shared_ptr<CommandBuffer>>& secondaryCommandBuffers) const
+	{
+		if (secondaryCommandBuffers.empty()) {
+			return;
+		}
+		std::vector<VkCommandBuffer> vkCommandBuffers(secondaryCommandBuffers.size());
+		for (size_t i = 0; i < secondaryCommandBuffers.size(); i++) {
+			vkCommandBuffers[i] = secondaryCommandBuffers[i]->getVkCommandBuffer();
+		}
+		flushBarriers();
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(vkCommandBuffers.size()), vkCommandBuffers.data());
+		//the state bound by the primary is undefined after executing secondaries
+		invalidateState();
+	}
 	void CommandBuffer::bindGraphicPipeline(const GraphicPipeline& graphicPipeline) const
 	{
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicPipeline.getVkGraphicPipeline());
+		VkPipeline pipeline = graphicPipeline.getVkGraphicPipeline();
+		if (boundState.pipeline == pipeline) {
+			stats.elidedPipelineBinds++;
+			return;
+		}
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		boundState.pipeline = pipeline;
 	}
 	void CommandBuffer::bindVertexBuffer(const Buffer& vertexBuffer) const
 	{
 		VkBuffer vertexBuffers[] = { vertexBuffer.getVkBuffer() };
 		VkDeviceSize offsets[] = { 0 };
+		if (boundState.vertexBuffer == vertexBuffers[0]) {
+			stats.elidedVertexBufferBinds++;
+			return;
+		}
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		boundState.vertexBuffer = vertexBuffers[0];
 	}
 	void CommandBuffer::bindIndexBuffer(const Buffer& indexBuffer, VkIndexType indexType) const
 	{
+		if (boundState.indexBuffer == indexBuffer.getVkBuffer() && boundState.indexType == indexType) {
+			stats.elidedIndexBufferBinds++;
+			return;
+		}
 		vkCmdBindIndexBuffer(commandBuffer, indexBuffer.getVkBuffer(), 0, indexType);
+		boundState.indexBuffer = indexBuffer.getVkBuffer();
+		boundState.indexType = indexType;
 	}
 	void CommandBuffer::bindGraphicDescriptorSet(const GraphicPipeline& graphicPipeline, std::shared_ptr<DescriptorSet> descriptorSet) const
 	{
+		bindGraphicDescriptorSet(graphicPipeline, descriptorSet, {});
+	}
+	void CommandBuffer::bindGraphicDescriptorSet(const GraphicPipeline& graphicPipeline, std::shared_ptr<DescriptorSet> descriptorSet, const std::vector<uint32_t>& dynamicOffsets) const
+	{
+		//one offset per dynamic binding of the set, in binding order
 		VkDescriptorSet vkDescriptorSet = descriptorSet->getVkDescriptorSet();
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicPipeline.getVkPipelineLayout(), 0, 1, &vkDescriptorSet, 0, VK_NULL_HANDLE);
+		VkPipelineLayout pipelineLayout = graphicPipeline.getVkPipelineLayout();
+		if (boundState.descriptorSet == vkDescriptorSet && boundState.descriptorSetLayout == pipelineLayout && boundState.dynamicOffsets == dynamicOffsets) {
+			stats.elidedDescriptorSetBinds++;
+			return;
+		}
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &vkDescriptorSet,
+			static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+		boundState.descriptorSet = vkDescriptorSet;
+		boundState.descriptorSetLayout = pipelineLayout;
+		boundState.dynamicOffsets = dynamicOffsets;
 	}
 	void CommandBuffer::draw(const Swapchain& swapchain, uint32_t vertexCount, uint32_t instanceCount) const
 	{
-		VkExtent2D swapChainExtent = swapchain.getVkSwapChainExtent();
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapChainExtent.width);
-		viewport.height = static_cast<float>(swapChainExtent.height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		setViewportAndScissor(swapchain.getVkSwapChainExtent());
 
 		vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
 	}
 	void CommandBuffer::drawIndexed(const Swapchain& swapchain, uint32_t indexCount)
 	{
-		VkExtent2D swapChainExtent = swapchain.getVkSwapChainExtent();
+		setViewportAndScissor(swapchain.getVkSwapChainExtent());
+
+		vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+	}
+	void CommandBuffer::drawIndexed(const Swapchain& swapchain, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) const
+	{
+		setViewportAndScissor(swapchain.getVkSwapChainExtent());
+
+		vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	}
+	void CommandBuffer::drawIndexedIndirect(const Swapchain& swapchain, const Buffer& indirectBuffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride) const
+	{
+		setViewportAndScissor(swapchain.getVkSwapChainExtent());
+
+		vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer.getVkBuffer(), offset, drawCount, stride);
+	}
+	void CommandBuffer::drawIndexedIndirectCount(const Swapchain& swapchain, const Buffer& indirectBuffer, VkDeviceSize offset, const Buffer& countBuffer, VkDeviceSize countOffset,
+		uint32_t maxDrawCount, uint32_t stride) const
+	{
+		if (!device_ptr->getFeatures().drawIndirectCount) {
+			throw std::runtime_error("draw indirect count is not supported by this device");
+		}
+		setViewportAndScissor(swapchain.getVkSwapChainExtent());
+
+		vkCmdDrawIndexedIndirectCount(commandBuffer, indirectBuffer.getVkBuffer(), offset, countBuffer.getVkBuffer(), countOffset, maxDrawCount, stride);
+	}
+	void CommandBuffer::bindComputePipeline(const ComputePipeline& computePipeline) const
+	{
+		VkPipeline pipeline = computePipeline.getVkComputePipeline();
+		if (boundState.computePipeline == pipeline) {
+			stats.elidedPipelineBinds++;
+			return;
+		}
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		boundState.computePipeline = pipeline;
+	}
+#ifdef VK_EXT_descriptor_buffer
+	void CommandBuffer::bindGraphicDescriptorSet(const GraphicPipeline& graphicPipeline, const DescriptorBuffer& descriptorBuffer, VkDeviceSize offset, uint32_t set) const
+	{
+		bindDescriptorBuffer(descriptorBuffer);
+		descriptorBuffer.cmdSetOffset(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicPipeline.getVkPipelineLayout(), set, offset);
+		//the set bound through vkCmdBindDescriptorSets is replaced
+		boundState.descriptorSet = VK_NULL_HANDLE;
+	}
+#endif
+	void CommandBuffer::bindComputeDescriptorSet(const ComputePipeline& computePipeline, std::shared_ptr<DescriptorSet> descriptorSet) const
+	{
+		bindComputeDescriptorSet(computePipeline, descriptorSet, {});
+	}
+	void CommandBuffer::bindComputeDescriptorSet(const ComputePipeline& computePipeline, std::shared_ptr<DescriptorSet> descriptorSet, const std::vector<uint32_t>& dynamicOffsets) const
+	{
+		VkDescriptorSet vkDescriptorSet = descriptorSet->getVkDescriptorSet();
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline.getVkPipelineLayout(), 0, 1, &vkDescriptorSet,
+			static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+	}
+#ifdef VK_EXT_descriptor_buffer
+	void CommandBuffer::bindComputeDescriptorSet(const ComputePipeline& computePipeline, const DescriptorBuffer& descriptorBuffer, VkDeviceSize offset, uint32_t set) const
+	{
+		bindDescriptorBuffer(descriptorBuffer);
+		descriptorBuffer.cmdSetOffset(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline.getVkPipelineLayout(), set, offset);
+	}
+#endif
+	void CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const
+	{
+		flushBarriers();
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+	void CommandBuffer::dispatchIndirect(const Buffer& indirectBuffer, VkDeviceSize offset) const
+	{
+		flushBarriers();
+		vkCmdDispatchIndirect(commandBuffer, indirectBuffer.getVkBuffer(), offset);
+	}
+	void CommandBuffer::pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* data) const
+	{
+		vkCmdPushConstants(commandBuffer, pipelineLayout, stageFlags, offset, size, data);
+	}
+	void CommandBuffer::fillBuffer(const Buffer& buffer, uint32_t value, uint64_t offset, uint64_t size) const
+	{
+		flushBarriers();
+		vkCmdFillBuffer(commandBuffer, buffer.getVkBuffer(), offset, size, value);
+	}
+	void CommandBuffer::memoryBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) const
+	{
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		flushBarriers();
+		vkCmdPipelineBarrier(commandBuffer,
+			srcStageMask, dstStageMask, 0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr);
+	}
+	void CommandBuffer::bufferBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, const std::vector<BufferBarrier>& barriers) const
+	{
+		std::vector<VkBufferMemoryBarrier> vkBarriers(barriers.size());
+		for (size_t i = 0; i < barriers.size(); i++) {
+			VkBufferMemoryBarrier& barrier = vkBarriers[i];
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = barriers[i].srcAccessMask;
+			barrier.dstAccessMask = barriers[i].dstAccessMask;
+			barrier.srcQueueFamilyIndex = barriers[i].srcQueueFamilyIndex;
+			barrier.dstQueueFamilyIndex = barriers[i].dstQueueFamilyIndex;
+			barrier.buffer = barriers[i].buffer->getVkBuffer();
+			barrier.offset = barriers[i].offset;
+			barrier.size = barriers[i].size;
+		}
+		flushBarriers();
+		vkCmdPipelineBarrier(commandBuffer,
+			srcStageMask, dstStageMask, 0,
+			0, nullptr,
+			static_cast<uint32_t>(vkBarriers.size()), vkBarriers.data(),
+			0, nullptr);
+	}
+	void CommandBuffer::requireAccess(Texture& texture, ResourceAccess access, uint32_t baseMipLevel, uint32_t levelCount) const
+	{
+		if (getAccessInfo(access).layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+			throw std::invalid_argument("this access can't be used on an image");
+		}
+		uint32_t lastLevel = levelCount == VK_REMAINING_MIP_LEVELS ? texture.getMipLevels() : baseMipLevel + levelCount;
+		if (baseMipLevel >= lastLevel || lastLevel > texture.getMipLevels()) {
+			throw std::invalid_argument("mip levels out of range");
+		}
+
+		//barriers of one batch are not ordered with each other, a level already waiting for one goes out first
+		VkImage vkImage = texture.getVkImage();
+		for (const auto& pending : pendingBarriers.imageBarriers) {
+			if (pending.image == vkImage && pending.subresourceRange.baseMipLevel < lastLevel
+				&& baseMipLevel < pending.subresourceRange.baseMipLevel + pending.subresourceRange.levelCount) {
+				flushBarriers();
+				break;
+			}
+		}
+
+		VkImageAspectFlags aspectMask = getImageAspectMask(texture.getVkFormat());
+
+		for (uint32_t level = baseMipLevel; level < lastLevel; level++) {
+			StateTransition transition{};
+			if (!transitionState(texture.getResourceState(level), access, true, transition)) {
+				continue;
+			}
+
+			//consecutive levels coming from the same state share one barrier
+			if (!pendingBarriers.imageBarriers.empty()) {
+				VkImageMemoryBarrier2& previous = pendingBarriers.imageBarriers.back();
+				if (previous.image == vkImage && previous.subresourceRange.baseMipLevel + previous.subresourceRange.levelCount == level
+					&& previous.srcStageMask == transition.srcStageMask && previous.srcAccessMask == transition.srcAccessMask
+					&& previous.dstStageMask == transition.dstStageMask && previous.dstAccessMask == transition.dstAccessMask
+					&& previous.oldLayout == transition.oldLayout && previous.newLayout == transition.newLayout) {
+					previous.subresourceRange.levelCount++;
+					continue;
+				}
+			}
+
+			VkImageMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			barrier.srcStageMask = transition.srcStageMask;
+			barrier.srcAccessMask = transition.srcAccessMask;
+			barrier.dstStageMask = transition.dstStageMask;
+			barrier.dstAccessMask = transition.dstAccessMask;
+			barrier.oldLayout = transition.oldLayout;
+			barrier.newLayout = transition.newLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = vkImage;
+			barrier.subresourceRange.aspectMask = aspectMask;
+			barrier.subresourceRange.baseMipLevel = level;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+			pendingBarriers.imageBarriers.push_back(barrier);
+		}
+	}
+	void CommandBuffer::requireAccess(const Buffer& buffer, ResourceAccess access) const
+	{
+		VkBuffer vkBuffer = buffer.getVkBuffer();
+		for (const auto& pending : pendingBarriers.bufferBarriers) {
+			if (pending.buffer == vkBuffer) {
+				flushBarriers();
+				break;
+			}
+		}
+
+		StateTransition transition{};
+		if (!transitionState(buffer.getResourceState(), access, false, transition)) {
+			return;
+		}
+
+		VkBufferMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+		barrier.srcStageMask = transition.srcStageMask;
+		barrier.srcAccessMask = transition.srcAccessMask;
+		barrier.dstStageMask = transition.dstStageMask;
+		barrier.dstAccessMask = transition.dstAccessMask;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = vkBuffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		pendingBarriers.bufferBarriers.push_back(barrier);
+	}
+	void CommandBuffer::requireAccess(VkImage image, VkImageAspectFlags aspectMask, ResourceState& state, ResourceAccess access) const
+	{
+		if (getAccessInfo(access).layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+			throw std::invalid_argument("this access can't be used on an image");
+		}
+		for (const auto& pending : pendingBarriers.imageBarriers) {
+			if (pending.image == image) {
+				flushBarriers();
+				break;
+			}
+		}
+
+		StateTransition transition{};
+		if (!transitionState(state, access, true, transition)) {
+			return;
+		}
+		pendingBarriers.imageBarriers.push_back(getAttachmentBarrier(image, aspectMask, transition.srcStageMask, transition.srcAccessMask,
+			transition.dstStageMask, transition.dstAccessMask, transition.oldLayout, transition.newLayout));
+	}
+	void CommandBuffer::flushBarriers() const
+	{
+		if (pendingBarriers.imageBarriers.empty() && pendingBarriers.bufferBarriers.empty()) {
+			return;
+		}
+
+		if (device_ptr->getFeatures().synchronization2) {
+			VkDependencyInfo dependencyInfo{};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(pendingBarriers.bufferBarriers.size());
+			dependencyInfo.pBufferMemoryBarriers = pendingBarriers.bufferBarriers.data();
+			dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(pendingBarriers.imageBarriers.size());
+			dependencyInfo.pImageMemoryBarriers = pendingBarriers.imageBarriers.data();
+			vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+		}
+		else {
+			//every stage and access the tracker uses has the same value in the old flags, the stages are merged
+			VkPipelineStageFlags srcStageMask = 0;
+			VkPipelineStageFlags dstStageMask = 0;
+			std::vector<VkBufferMemoryBarrier> bufferBarriers(pendingBarriers.bufferBarriers.size());
+			for (size_t i = 0; i < bufferBarriers.size(); i++) {
+				const VkBufferMemoryBarrier2& pending = pendingBarriers.bufferBarriers[i];
+				VkBufferMemoryBarrier& barrier = bufferBarriers[i];
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.srcAccessMask = static_cast<VkAccessFlags>(pending.srcAccessMask);
+				barrier.dstAccessMask = static_cast<VkAccessFlags>(pending.dstAccessMask);
+				barrier.srcQueueFamilyIndex = pending.srcQueueFamilyIndex;
+				barrier.dstQueueFamilyIndex = pending.dstQueueFamilyIndex;
+				barrier.buffer = pending.buffer;
+				barrier.offset = pending.offset;
+				barrier.size = pending.size;
+				srcStageMask |= static_cast<VkPipelineStageFlags>(pending.srcStageMask);
+				dstStageMask |= static_cast<VkPipelineStageFlags>(pending.dstStageMask);
+			}
+			std::vector<VkImageMemoryBarrier> imageBarriers(pendingBarriers.imageBarriers.size());
+			for (size_t i = 0; i < imageBarriers.size(); i++) {
+				const VkImageMemoryBarrier2& pending = pendingBarriers.imageBarriers[i];
+				VkImageMemoryBarrier& barrier = imageBarriers[i];
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = static_cast<VkAccessFlags>(pending.srcAccessMask);
+				barrier.dstAccessMask = static_cast<VkAccessFlags>(pending.dstAccessMask);
+				barrier.oldLayout = pending.oldLayout;
+				barrier.newLayout = pending.newLayout;
+				barrier.srcQueueFamilyIndex = pending.srcQueueFamilyIndex;
+				barrier.dstQueueFamilyIndex = pending.dstQueueFamilyIndex;
+				barrier.image = pending.image;
+				barrier.subresourceRange = pending.subresourceRange;
+				srcStageMask |= static_cast<VkPipelineStageFlags>(pending.srcStageMask);
+				dstStageMask |= static_cast<VkPipelineStageFlags>(pending.dstStageMask);
+			}
+
+			vkCmdPipelineBarrier(commandBuffer,
+				srcStageMask != 0 ? srcStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+				dstStageMask != 0 ? dstStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT), 0,
+				0, nullptr,
+				static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+				static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+		}
+
+		pendingBarriers.imageBarriers.clear();
+		pendingBarriers.bufferBarriers.clear();
+	}
+	void CommandBuffer::setViewportAndScissor(VkExtent2D extent) const
+	{
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapChainExtent.width);
-		viewport.height = static_cast<float>(swapChainExtent.height);
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		if (boundState.hasViewport && boundState.viewport.x == viewport.x && boundState.viewport.y == viewport.y
+			&& boundState.viewport.width == viewport.width && boundState.viewport.height == viewport.height
+			&& boundState.viewport.minDepth == viewport.minDepth && boundState.viewport.maxDepth == viewport.maxDepth) {
+			stats.elidedViewports++;
+		}
+		else {
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			boundState.hasViewport = true;
+			boundState.viewport = viewport;
+		}
 
 		VkRect2D scissor{};
 		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-		vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+		scissor.extent = extent;
+		if (boundState.hasScissor && boundState.scissor.offset.x == scissor.offset.x && boundState.scissor.offset.y == scissor.offset.y
+			&& boundState.scissor.extent.width == scissor.extent.width && boundState.scissor.extent.height == scissor.extent.height) {
+			stats.elidedScissors++;
+		}
+		else {
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+			boundState.hasScissor = true;
+			boundState.scissor = scissor;
+		}
+	}
+#ifdef VK_EXT_descriptor_buffer
+	void CommandBuffer::bindDescriptorBuffer(const DescriptorBuffer& descriptorBuffer) const
+	{
+		//binding the buffers is expensive on some drivers, offsets are changed far more often
+		if (boundState.descriptorBuffer == descriptorBuffer.getVkBuffer()) {
+			return;
+		}
+		descriptorBuffer.cmdBind(commandBuffer);
+		boundState.descriptorBuffer = descriptorBuffer.getVkBuffer();
+	}
+#endif
+	void CommandBuffer::invalidateState() const
+	{
+		boundState = BoundState();
+	}
+	const CommandBufferStats& CommandBuffer::getStats() const
+	{
+		return stats;
+	}
+	void CommandBuffer::resetStats() const
+	{
+		stats = CommandBufferStats();
 	}
 	void CommandBuffer::QueueSubmit(const std::vector<const Semaphore*>& waitSemaphores, const std::vector<const Semaphore*>& signalSemaphores, const Fence *pFence) const
 	{
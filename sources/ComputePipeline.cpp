@@ -0,0 +1,61 @@
+#include <ComputePipeline.hpp>
+
+namespace basicvk {
+	ComputePipeline::ComputePipeline(std::shared_ptr<Device> device, const Shader& shader, ComputePipelineInfo pipelineInfo)
+		: device_ptr(device), computePipeline(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE)
+	{
+		std::vector<VkDescriptorSetLayout> vkDescriptorSetLayouts;
+		for (const DescriptorSetLayout* descriptorSetLayout : pipelineInfo.descriptorSetLayouts) {
+			vkDescriptorSetLayouts.push_back(descriptorSetLayout->getVkDescriptorSetLayout());
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(vkDescriptorSetLayouts.size());
+		pipelineLayoutCreateInfo.pSetLayouts = vkDescriptorSetLayouts.data();
+		pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pipelineInfo.pushConstantRanges.size());
+		pipelineLayoutCreateInfo.pPushConstantRanges = pipelineInfo.pushConstantRanges.data();
+		if (vkCreatePipelineLayout(device->getVkDevice(), &pipelineLayoutCreateInfo, VK_NULL_HANDLE, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("unable to create pipline layout");
+		}
+
+		VkComputePipelineCreateInfo pipelineCreateInfo{};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+#ifdef VK_EXT_descriptor_buffer
+		pipelineCreateInfo.flags = pipelineInfo.descriptorBuffer ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+#else
+		if (pipelineInfo.descriptorBuffer) {
+			throw std::runtime_error("descriptor buffers are not supported by the vulkan headers");
+		}
+#endif
+		pipelineCreateInfo.stage = shader.getComputeShaderStageCreateInfo();
+		pipelineCreateInfo.layout = pipelineLayout;
+		pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCreateInfo.basePipelineIndex = -1;
+
+		if (vkCreateComputePipelines(device->getVkDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, VK_NULL_HANDLE, &computePipeline) != VK_SUCCESS) {
+			vkDestroyPipelineLayout(device->getVkDevice(), pipelineLayout, VK_NULL_HANDLE);
+			pipelineLayout = VK_NULL_HANDLE;
+			throw std::runtime_error("unable to create compute pipeline");
+		}
+	}
+	ComputePipeline::~ComputePipeline()
+	{
+		if (computePipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(device_ptr->getVkDevice(), computePipeline, VK_NULL_HANDLE);
+			computePipeline = VK_NULL_HANDLE;
+		}
+		if (pipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(device_ptr->getVkDevice(), pipelineLayout, VK_NULL_HANDLE);
+			pipelineLayout = VK_NULL_HANDLE;
+		}
+	}
+	VkPipeline ComputePipeline::getVkComputePipeline() const
+	{
+		return computePipeline;
+	}
+	VkPipelineLayout ComputePipeline::getVkPipelineLayout() const
+	{
+		return pipelineLayout;
+	}
+}
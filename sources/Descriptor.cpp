@@ -7,6 +7,7 @@ namespace basicvk {
 	{
 		VkDescriptorPoolCreateInfo descriptorCreateInfo{};
 		descriptorCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorCreateInfo.flags = createInfo.flags;
 		descriptorCreateInfo.maxSets = createInfo.maxSets;
 		descriptorCreateInfo.poolSizeCount = static_cast<uint32_t>(createInfo.poolSizes.size());
 		descriptorCreateInfo.pPoolSizes = createInfo.poolSizes.data();
@@ -33,11 +34,12 @@ namespace basicvk {
 		return DescriptorPool(other);
 	}
 
-	std::shared_ptr<DescriptorSet> DescriptorPool::allocateDescriptorSet(const DescriptorSetLayout& descriptorSetLayout)
+	std::shared_ptr<DescriptorSet> DescriptorPool::allocateDescriptorSet(const DescriptorSetLayout& descriptorSetLayout, uint32_t variableDescriptorCount)
 	{
 		DescriptorSetAllocateInfo allocateInfo{};
 		allocateInfo.descriptorPool = this->descriptorPool;
 		allocateInfo.descriptorSetLayout = descriptorSetLayout.getVkDescriptorSetLayout();
+		allocateInfo.variableDescriptorCount = variableDescriptorCount;
 		std::shared_ptr<DescriptorSet> descriptorSet = std::make_shared<DescriptorSet>(device_ptr, allocateInfo);
 		descriptorSets.push_back(descriptorSet);
 		return descriptorSet;
@@ -59,6 +61,12 @@ namespace basicvk {
 		return res;
 	}
 
+	void DescriptorPool::reset()
+	{
+		vkResetDescriptorPool(device_ptr->getVkDevice(), descriptorPool, 0);
+		descriptorSets.clear();
+	}
+
 	DescriptorSet::DescriptorSet(std::shared_ptr<Device> device, DescriptorSetAllocateInfo allocateInfo)
 		: descriptorSet(VK_NULL_HANDLE), device_ptr(device)
 	{
@@ -69,11 +77,24 @@ namespace basicvk {
 		descriptorAllocateInfo.descriptorSetCount = 1;
 		descriptorAllocateInfo.pSetLayouts = &descriptorSetLayout;
 
+		VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+		variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+		variableCountInfo.descriptorSetCount = 1;
+		variableCountInfo.pDescriptorCounts = &allocateInfo.variableDescriptorCount;
+		if (allocateInfo.variableDescriptorCount != 0) {
+			descriptorAllocateInfo.pNext = &variableCountInfo;
+		}
+
 		if (vkAllocateDescriptorSets(device->getVkDevice(), &descriptorAllocateInfo, &descriptorSet) != VK_SUCCESS) {
 			throw std::runtime_error("failed to allocate descriptorSet");
 		}
 	}
 
+	DescriptorSet::DescriptorSet(std::shared_ptr<Device> device, VkDescriptorSet descriptorSet)
+		: descriptorSet(descriptorSet), device_ptr(device)
+	{
+	}
+
 	DescriptorSet::DescriptorSet(DescriptorSet& other)
 		: descriptorSet(other.descriptorSet)
 	{
@@ -94,11 +115,17 @@ namespace basicvk {
 	{
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets;
 		std::vector<BufferUpdateInfo>& bufferInfos = descriptorSetUpdateInfo.bufferInfos;
+		std::vector<TextureUpdateInfo>& textureInfos = descriptorSetUpdateInfo.textureInfos;
+
+		//the writes point into these, they have to outlive the loops below
+		std::vector<VkDescriptorBufferInfo> vkBufferInfos(bufferInfos.size());
+		std::vector<VkDescriptorImageInfo> vkImageInfos(textureInfos.size());
+
 		for (size_t i = 0; i < bufferInfos.size(); i++)
 		{
-			VkDescriptorBufferInfo bufferInfo{};
+			VkDescriptorBufferInfo& bufferInfo = vkBufferInfos[i];
 			bufferInfo.buffer = bufferInfos[i].buffer;
-			bufferInfo.offset = 0;
+			bufferInfo.offset = bufferInfos[i].offset;
 			bufferInfo.range = bufferInfos[i].range;
 
 			VkWriteDescriptorSet descriptorWrite{};
@@ -114,11 +141,10 @@ namespace basicvk {
 			writeDescriptorSets.push_back(descriptorWrite);
 		}
 
-		std::vector<TextureUpdateInfo>& textureInfos = descriptorSetUpdateInfo.textureInfos;
 		for (size_t i = 0; i < textureInfos.size(); i++)
 		{
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			VkDescriptorImageInfo& imageInfo = vkImageInfos[i];
+			imageInfo.imageLayout = textureInfos[i].imageLayout;
 			imageInfo.imageView = textureInfos[i].imageView;
 			imageInfo.sampler = textureInfos[i].sampler;
 
@@ -128,7 +154,7 @@ namespace basicvk {
 			descriptorWrite.dstBinding = textureInfos[i].binding;
 			descriptorWrite.dstArrayElement = textureInfos[i].arrayElement;
 			descriptorWrite.descriptorCount = 1;
-			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			descriptorWrite.descriptorType = textureInfos[i].type;
 			descriptorWrite.pImageInfo = &imageInfo;
 			descriptorWrite.pBufferInfo = VK_NULL_HANDLE;
 			descriptorWrite.pTexelBufferView = VK_NULL_HANDLE;
@@ -141,12 +167,24 @@ namespace basicvk {
 			0, VK_NULL_HANDLE);
 	}
 
-	DescriptorSetLayout::DescriptorSetLayout(std::shared_ptr<Device> device, const std::vector<DescriptorSetLayoutCreateInfo> &createInfo)
-		: device_ptr(device), descriptorSetLayout(VK_NULL_HANDLE)
+	void DescriptorSet::UpdateDescriptorSet(VkDescriptorUpdateTemplate updateTemplate, const void* data) const
+	{
+		vkUpdateDescriptorSetWithTemplate(device_ptr->getVkDevice(), descriptorSet, updateTemplate, data);
+	}
+
+	DescriptorSetLayout::DescriptorSetLayout(std::shared_ptr<Device> device, const std::vector<DescriptorSetLayoutCreateInfo> &createInfo, VkDescriptorSetLayoutCreateFlags flags)
+		: device_ptr(device), descriptorSetLayout(VK_NULL_HANDLE), bindings(createInfo)
 	{
 		std::vector<VkDescriptorSetLayoutBinding> layoutBindings(createInfo.size());
+		std::vector<VkDescriptorBindingFlags> bindingFlags(createInfo.size());
+		bool hasBindingFlags = false;
+		bool updateAfterBind = false;
 		for (size_t i = 0; i < createInfo.size(); i++)
 		{
+			bindingFlags[i] = createInfo[i].bindingFlags;
+			hasBindingFlags |= bindingFlags[i] != 0;
+			updateAfterBind |= (bindingFlags[i] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
+
 			VkDescriptorSetLayoutBinding descriptorSetLayoutBinding{};
 			descriptorSetLayoutBinding.binding = createInfo[i].binding;
 			descriptorSetLayoutBinding.descriptorType = createInfo[i].descriptorType;
@@ -158,9 +196,21 @@ namespace basicvk {
 
 		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
 		descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutCreateInfo.flags = flags;
 		descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
 		descriptorSetLayoutCreateInfo.pBindings = layoutBindings.data();
 
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+		if (hasBindingFlags) {
+			descriptorSetLayoutCreateInfo.pNext = &bindingFlagsInfo;
+		}
+		if (updateAfterBind) {
+			descriptorSetLayoutCreateInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		}
+
 		if (vkCreateDescriptorSetLayout(device->getVkDevice(), &descriptorSetLayoutCreateInfo, VK_NULL_HANDLE, &this->descriptorSetLayout) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create descriptor set layout");
 		}
@@ -173,7 +223,7 @@ namespace basicvk {
 		}
 	}
 	DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout& other)
-		: device_ptr(other.device_ptr), descriptorSetLayout(other.descriptorSetLayout)
+		: device_ptr(other.device_ptr), descriptorSetLayout(other.descriptorSetLayout), bindings(other.bindings)
 	{
 		other.descriptorSetLayout = VK_NULL_HANDLE;
 	}
@@ -185,4 +235,8 @@ namespace basicvk {
 	{
 		return descriptorSetLayout;
 	}
+	const std::vector<DescriptorSetLayoutCreateInfo>& DescriptorSetLayout::getBindings() const
+	{
+		return bindings;
+	}
 }
\ No newline at end of file
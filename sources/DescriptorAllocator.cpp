@@ -0,0 +1,115 @@
+#include <DescriptorAllocator.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace basicvk {
+	DescriptorAllocator::DescriptorAllocator(std::shared_ptr<Device> device, DescriptorAllocatorOptions options)
+		: device_ptr(device), options(options), frames(options.frameCount), currentFrame(0)
+	{
+	}
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (auto& frame : frames) {
+			for (VkDescriptorPool pool : frame.pools) {
+				vkDestroyDescriptorPool(device_ptr->getVkDevice(), pool, VK_NULL_HANDLE);
+			}
+		}
+	}
+	void DescriptorAllocator::beginFrame(uint32_t frameIndex, bool resetPools)
+	{
+		currentFrame = frameIndex;
+		if (!resetPools) {
+			return;
+		}
+
+		Frame& frame = frames[frameIndex];
+		for (VkDescriptorPool pool : frame.pools) {
+			vkResetDescriptorPool(device_ptr->getVkDevice(), pool, 0);
+		}
+		frame.currentPool = 0;
+	}
+	std::shared_ptr<DescriptorSet> DescriptorAllocator::allocate(const DescriptorSetLayout& layout)
+	{
+		return allocate(std::vector<const DescriptorSetLayout*>{ &layout })[0];
+	}
+	std::vector<std::shared_ptr<DescriptorSet>> DescriptorAllocator::allocate(const std::vector<const DescriptorSetLayout*>& layouts)
+	{
+		std::vector<VkDescriptorSetLayout> vkLayouts(layouts.size());
+		for (size_t i = 0; i < layouts.size(); i++) {
+			vkLayouts[i] = layouts[i]->getVkDescriptorSetLayout();
+		}
+		std::vector<VkDescriptorSet> vkSets(layouts.size(), VK_NULL_HANDLE);
+
+		//the pools left after a reset are tried before a bigger one is created
+		Frame& frame = frames[currentFrame];
+		bool allocated = false;
+		while (!allocated && frame.currentPool < frame.pools.size()) {
+			allocated = tryAllocate(frame.pools[frame.currentPool], vkLayouts, vkSets);
+			if (!allocated) {
+				frame.currentPool++;
+			}
+		}
+		if (!allocated) {
+			float scale = std::pow(options.growthFactor, static_cast<float>(frame.pools.size()));
+			uint32_t maxSets = static_cast<uint32_t>(std::min(options.initialSetsPerPool * scale, static_cast<float>(options.maxSetsPerPool)));
+			maxSets = std::max(maxSets, static_cast<uint32_t>(layouts.size()));
+
+			frame.pools.push_back(createPool(maxSets));
+			frame.currentPool = static_cast<uint32_t>(frame.pools.size() - 1);
+			if (!tryAllocate(frame.pools.back(), vkLayouts, vkSets)) {
+				throw std::runtime_error("descriptor sets don't fit in a new pool, the pool ratios are too small");
+			}
+		}
+
+		std::vector<std::shared_ptr<DescriptorSet>> sets(vkSets.size());
+		for (size_t i = 0; i < vkSets.size(); i++) {
+			sets[i] = std::make_shared<DescriptorSet>(device_ptr, vkSets[i]);
+		}
+		return sets;
+	}
+	uint32_t DescriptorAllocator::getPoolCount() const
+	{
+		size_t count = 0;
+		for (const auto& frame : frames) {
+			count += frame.pools.size();
+		}
+		return static_cast<uint32_t>(count);
+	}
+	VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets) const
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& ratio : options.ratios) {
+			poolSizes.push_back({ ratio.type, std::max(1u, static_cast<uint32_t>(std::ceil(ratio.ratio * maxSets))) });
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = options.flags;
+		poolInfo.maxSets = maxSets;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(device_ptr->getVkDevice(), &poolInfo, VK_NULL_HANDLE, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor pool!");
+		}
+		return pool;
+	}
+	bool DescriptorAllocator::tryAllocate(VkDescriptorPool pool, const std::vector<VkDescriptorSetLayout>& layouts, std::vector<VkDescriptorSet>& sets) const
+	{
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = pool;
+		allocateInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+		allocateInfo.pSetLayouts = layouts.data();
+
+		VkResult result = vkAllocateDescriptorSets(device_ptr->getVkDevice(), &allocateInfo, sets.data());
+		if (result == VK_SUCCESS) {
+			return true;
+		}
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+			return false;
+		}
+		throw std::runtime_error("failed to allocate descriptorSet");
+	}
+}
@@ -0,0 +1,186 @@
+#include <DescriptorBuffer.hpp>
+
+#ifdef VK_EXT_descriptor_buffer
+namespace basicvk {
+	static const VkBufferUsageFlags DESCRIPTOR_BUFFER_USAGE = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT
+		| VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+	template<typename T>
+	static T loadDeviceFunction(VkDevice device, const char* name)
+	{
+		T function = reinterpret_cast<T>(vkGetDeviceProcAddr(device, name));
+		if (function == nullptr) {
+			throw std::runtime_error(std::string("unable to load ") + name);
+		}
+		return function;
+	}
+
+	DescriptorBuffer::DescriptorBuffer(std::shared_ptr<Device> device, DescriptorBufferOptions options)
+		: device_ptr(device), properties(getProperties(device))
+		, buffer(device, BufferOptions{ DESCRIPTOR_BUFFER_USAGE, VK_SHARING_MODE_EXCLUSIVE, MemoryUsage::Dynamic }, options.size)
+		, address(buffer.getDeviceAddress()), usedSize(0)
+	{
+		if (buffer.getMappedData() == nullptr) {
+			throw std::runtime_error("descriptor buffer memory is not host visible");
+		}
+
+		VkDevice vkDevice = device->getVkDevice();
+		getDescriptorSetLayoutSize = loadDeviceFunction<PFN_vkGetDescriptorSetLayoutSizeEXT>(vkDevice, "vkGetDescriptorSetLayoutSizeEXT");
+		getDescriptorSetLayoutBindingOffset = loadDeviceFunction<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(vkDevice, "vkGetDescriptorSetLayoutBindingOffsetEXT");
+		getDescriptor = loadDeviceFunction<PFN_vkGetDescriptorEXT>(vkDevice, "vkGetDescriptorEXT");
+		cmdBindDescriptorBuffers = loadDeviceFunction<PFN_vkCmdBindDescriptorBuffersEXT>(vkDevice, "vkCmdBindDescriptorBuffersEXT");
+		cmdSetDescriptorBufferOffsets = loadDeviceFunction<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(vkDevice, "vkCmdSetDescriptorBufferOffsetsEXT");
+	}
+	VkDeviceSize DescriptorBuffer::allocateSet(const DescriptorSetLayout& layout)
+	{
+		VkDeviceSize layoutSize = 0;
+		getDescriptorSetLayoutSize(device_ptr->getVkDevice(), layout.getVkDescriptorSetLayout(), &layoutSize);
+
+		VkDeviceSize alignment = properties.descriptorBufferOffsetAlignment;
+		VkDeviceSize offset = (usedSize + alignment - 1) / alignment * alignment;
+		if (offset + layoutSize > buffer.getBufferSize()) {
+			throw std::runtime_error("descriptor buffer is full");
+		}
+		usedSize = offset + layoutSize;
+		return offset;
+	}
+	void DescriptorBuffer::reset()
+	{
+		usedSize = 0;
+	}
+	void DescriptorBuffer::writeBuffer(VkDeviceSize setOffset, const DescriptorSetLayout& layout, uint32_t binding, uint32_t arrayElement, VkDescriptorType type,
+		const Buffer& resource, VkDeviceSize offset, VkDeviceSize range)
+	{
+		VkDescriptorAddressInfoEXT addressInfo{};
+		addressInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+		addressInfo.address = resource.getDeviceAddress() + offset;
+		addressInfo.range = range == VK_WHOLE_SIZE ? resource.getBufferSize() - offset : range;
+		addressInfo.format = VK_FORMAT_UNDEFINED;
+
+		VkDescriptorGetInfoEXT getInfo{};
+		getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+		getInfo.type = type;
+		switch (type) {
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			getInfo.data.pUniformBuffer = &addressInfo;
+			break;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			getInfo.data.pStorageBuffer = &addressInfo;
+			break;
+		default:
+			//dynamic buffers have no descriptor buffer equivalent, the offset goes in the address instead
+			throw std::invalid_argument("descriptor type not supported by descriptor buffers");
+		}
+		write(setOffset, layout, binding, arrayElement, getInfo);
+	}
+	void DescriptorBuffer::writeTexture(VkDeviceSize setOffset, const DescriptorSetLayout& layout, const TextureUpdateInfo& textureInfo)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = textureInfo.sampler;
+		imageInfo.imageView = textureInfo.imageView;
+		imageInfo.imageLayout = textureInfo.imageLayout;
+
+		VkDescriptorGetInfoEXT getInfo{};
+		getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+		getInfo.type = textureInfo.type;
+		switch (textureInfo.type) {
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			getInfo.data.pSampler = &textureInfo.sampler;
+			break;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			getInfo.data.pCombinedImageSampler = &imageInfo;
+			break;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			getInfo.data.pSampledImage = &imageInfo;
+			break;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			getInfo.data.pStorageImage = &imageInfo;
+			break;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			getInfo.data.pInputAttachmentImage = &imageInfo;
+			break;
+		default:
+			throw std::invalid_argument("descriptor type not supported by descriptor buffers");
+		}
+		write(setOffset, layout, textureInfo.binding, textureInfo.arrayElement, getInfo);
+	}
+	void DescriptorBuffer::flush()
+	{
+		if (usedSize > 0) {
+			buffer.flush(0, usedSize);
+		}
+	}
+	void DescriptorBuffer::cmdBind(VkCommandBuffer commandBuffer) const
+	{
+		//resources and samplers share the buffer, so it is the only binding
+		VkDescriptorBufferBindingInfoEXT bindingInfo{};
+		bindingInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+		bindingInfo.address = address;
+		bindingInfo.usage = DESCRIPTOR_BUFFER_USAGE;
+		cmdBindDescriptorBuffers(commandBuffer, 1, &bindingInfo);
+	}
+	void DescriptorBuffer::cmdSetOffset(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, VkDeviceSize offset) const
+	{
+		uint32_t bufferIndex = 0;
+		cmdSetDescriptorBufferOffsets(commandBuffer, bindPoint, pipelineLayout, set, 1, &bufferIndex, &offset);
+	}
+	VkBuffer DescriptorBuffer::getVkBuffer() const
+	{
+		return buffer.getVkBuffer();
+	}
+	VkDeviceSize DescriptorBuffer::getUsedSize() const
+	{
+		return usedSize;
+	}
+	VkPhysicalDeviceDescriptorBufferPropertiesEXT DescriptorBuffer::getProperties(std::shared_ptr<Device> device)
+	{
+		//checked before the buffer is created with the descriptor buffer usages
+		if (!device->getFeatures().descriptorBuffer) {
+			throw std::runtime_error("descriptor buffers are not supported by the device");
+		}
+
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties{};
+		descriptorBufferProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &descriptorBufferProperties;
+		vkGetPhysicalDeviceProperties2(device->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
+		return descriptorBufferProperties;
+	}
+	size_t DescriptorBuffer::getDescriptorSize(VkDescriptorType type) const
+	{
+		switch (type) {
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			return properties.samplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return properties.combinedImageSamplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			return properties.sampledImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			return properties.storageImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return properties.inputAttachmentDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			return properties.uniformBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			return properties.storageBufferDescriptorSize;
+		default:
+			throw std::invalid_argument("descriptor type not supported by descriptor buffers");
+		}
+	}
+	void DescriptorBuffer::write(VkDeviceSize setOffset, const DescriptorSetLayout& layout, uint32_t binding, uint32_t arrayElement, const VkDescriptorGetInfoEXT& getInfo)
+	{
+		VkDeviceSize bindingOffset = 0;
+		getDescriptorSetLayoutBindingOffset(device_ptr->getVkDevice(), layout.getVkDescriptorSetLayout(), binding, &bindingOffset);
+
+		//array elements of a binding are tightly packed
+		size_t descriptorSize = getDescriptorSize(getInfo.type);
+		VkDeviceSize descriptorOffset = setOffset + bindingOffset + static_cast<VkDeviceSize>(arrayElement) * descriptorSize;
+		if (descriptorOffset + descriptorSize > buffer.getBufferSize()) {
+			throw std::out_of_range("descriptor is written past the end of the descriptor buffer");
+		}
+		char* destination = static_cast<char*>(buffer.getMappedData()) + descriptorOffset;
+		getDescriptor(device_ptr->getVkDevice(), &getInfo, descriptorSize, destination);
+	}
+}
+#endif
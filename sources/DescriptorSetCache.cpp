@@ -0,0 +1,166 @@
+#include <DescriptorSetCache.hpp>
+#include <functional>
+
+namespace basicvk {
+	static bool isBufferDescriptor(VkDescriptorType type)
+	{
+		switch (type) {
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			return true;
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return false;
+		default:
+			throw std::invalid_argument("descriptor type not supported by the descriptor set cache");
+		}
+	}
+
+	static DescriptorAllocatorOptions getAllocatorOptions(const DescriptorSetCacheOptions& options)
+	{
+		DescriptorAllocatorOptions allocatorOptions{};
+		allocatorOptions.frameCount = options.frameCount;
+		allocatorOptions.initialSetsPerPool = options.setsPerPool;
+		return allocatorOptions;
+	}
+
+	bool DescriptorResource::operator==(const DescriptorResource& other) const
+	{
+		return buffer == other.buffer && offset == other.offset && range == other.range
+			&& imageView == other.imageView && sampler == other.sampler && imageLayout == other.imageLayout;
+	}
+
+	DescriptorSetCache::DescriptorSetCache(std::shared_ptr<Device> device, DescriptorSetCacheOptions options)
+		: device_ptr(device), options(options), allocator(device, getAllocatorOptions(options))
+		, frames(options.frameCount), currentFrame(0), templates(), scratch()
+		, hitCount(0), missCount(0)
+	{
+	}
+	DescriptorSetCache::~DescriptorSetCache()
+	{
+		for (auto& entry : templates) {
+			vkDestroyDescriptorUpdateTemplate(device_ptr->getVkDevice(), entry.second.updateTemplate, VK_NULL_HANDLE);
+		}
+	}
+	void DescriptorSetCache::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex % static_cast<uint32_t>(frames.size());
+		Frame& frame = frames[currentFrame];
+		bool stale = frame.invalidated;
+		for (auto& entry : frame.sets) {
+			stale |= !entry.second.used;
+			entry.second.used = false;
+		}
+		//sets can't be freed one by one, a frame with unused sets starts over
+		allocator.beginFrame(currentFrame, stale);
+		if (stale) {
+			frame.sets.clear();
+			frame.invalidated = false;
+		}
+	}
+	void DescriptorSetCache::invalidate()
+	{
+		for (auto& frame : frames) {
+			frame.invalidated = true;
+		}
+	}
+	std::shared_ptr<DescriptorSet> DescriptorSetCache::getDescriptorSet(const DescriptorSetLayout& layout, const std::vector<DescriptorResource>& resources)
+	{
+		Frame& frame = frames[currentFrame];
+		VkDescriptorSetLayout vkLayout = layout.getVkDescriptorSetLayout();
+		size_t key = hash(vkLayout, resources);
+
+		auto range = frame.sets.equal_range(key);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second.layout == vkLayout && it->second.resources == resources) {
+				hitCount++;
+				it->second.used = true;
+				return it->second.descriptorSet;
+			}
+		}
+
+		const UpdateTemplate& updateTemplate = getUpdateTemplate(layout);
+		if (resources.size() != updateTemplate.isBuffer.size()) {
+			throw std::invalid_argument("one resource per descriptor of the layout is needed");
+		}
+
+		scratch.resize(resources.size());
+		for (size_t i = 0; i < resources.size(); i++) {
+			if (updateTemplate.isBuffer[i]) {
+				scratch[i].buffer = { resources[i].buffer, resources[i].offset, resources[i].range };
+			}
+			else {
+				scratch[i].image = { resources[i].sampler, resources[i].imageView, resources[i].imageLayout };
+			}
+		}
+
+		std::shared_ptr<DescriptorSet> descriptorSet = allocator.allocate(layout);
+		descriptorSet->UpdateDescriptorSet(updateTemplate.updateTemplate, scratch.data());
+		frame.sets.insert({ key, { vkLayout, resources, descriptorSet, true } });
+		missCount++;
+		return descriptorSet;
+	}
+	uint64_t DescriptorSetCache::getHitCount() const
+	{
+		return hitCount;
+	}
+	uint64_t DescriptorSetCache::getMissCount() const
+	{
+		return missCount;
+	}
+	const DescriptorSetCache::UpdateTemplate& DescriptorSetCache::getUpdateTemplate(const DescriptorSetLayout& layout)
+	{
+		VkDescriptorSetLayout vkLayout = layout.getVkDescriptorSetLayout();
+		auto it = templates.find(vkLayout);
+		if (it != templates.end()) {
+			return it->second;
+		}
+
+		//every descriptor of the set gets one DescriptorData, binding after binding
+		UpdateTemplate updateTemplate{};
+		std::vector<VkDescriptorUpdateTemplateEntry> entries;
+		for (const auto& binding : layout.getBindings()) {
+			VkDescriptorUpdateTemplateEntry entry{};
+			entry.dstBinding = binding.binding;
+			entry.dstArrayElement = 0;
+			entry.descriptorCount = binding.descriptorCount;
+			entry.descriptorType = binding.descriptorType;
+			entry.offset = updateTemplate.isBuffer.size() * sizeof(DescriptorData);
+			entry.stride = sizeof(DescriptorData);
+			entries.push_back(entry);
+			updateTemplate.isBuffer.insert(updateTemplate.isBuffer.end(), binding.descriptorCount, isBufferDescriptor(binding.descriptorType));
+		}
+
+		VkDescriptorUpdateTemplateCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+		createInfo.pDescriptorUpdateEntries = entries.data();
+		createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		createInfo.descriptorSetLayout = vkLayout;
+		if (vkCreateDescriptorUpdateTemplate(device_ptr->getVkDevice(), &createInfo, VK_NULL_HANDLE, &updateTemplate.updateTemplate) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create descriptor update template");
+		}
+		return templates.emplace(vkLayout, std::move(updateTemplate)).first->second;
+	}
+	size_t DescriptorSetCache::hash(VkDescriptorSetLayout layout, const std::vector<DescriptorResource>& resources)
+	{
+		size_t seed = std::hash<VkDescriptorSetLayout>()(layout);
+		auto combine = [&seed](size_t value) {
+			seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+		};
+		for (const auto& resource : resources) {
+			combine(std::hash<VkBuffer>()(resource.buffer));
+			combine(std::hash<VkDeviceSize>()(resource.offset));
+			combine(std::hash<VkDeviceSize>()(resource.range));
+			combine(std::hash<VkImageView>()(resource.imageView));
+			combine(std::hash<VkSampler>()(resource.sampler));
+			combine(std::hash<uint32_t>()(static_cast<uint32_t>(resource.imageLayout)));
+		}
+		return seed;
+	}
+}
@@ -1,16 +1,28 @@
 #include <Device.hpp>
 #include <Command.hpp>
 #include <Synchronous.hpp>
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 namespace basicvk {
 	Device::Device(std::shared_ptr<PhysicalDevice> physicalDevicePtr)
-		: device(VK_NULL_HANDLE), physicalDevice(physicalDevicePtr)
+		: device(VK_NULL_HANDLE), physicalDevice(physicalDevicePtr), features(), memoryAllocator(), samplerCache()
 	{
-		const std::vector<const char*> deviceExtensions = {
+		std::vector<const char*> deviceExtensions = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
 
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevicePtr->getVkPhysicalDevice(), nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevicePtr->getVkPhysicalDevice(), nullptr, &extensionCount, availableExtensions.data());
+#ifdef VK_EXT_descriptor_buffer
+		bool hasDescriptorBuffer = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& extension) {
+			return std::strcmp(extension.extensionName, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) == 0;
+		});
+#endif
+
 		QueueFamilyIndices indices = physicalDevicePtr->getQueueFamillyIndices();
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies;
@@ -20,6 +32,12 @@ namespace basicvk {
 		if (indices.presentFamily.has_value()) {
 			uniqueQueueFamilies.insert(indices.presentFamily.value());
 		}
+		if (indices.transferFamily.has_value()) {
+			uniqueQueueFamilies.insert(indices.transferFamily.value());
+		}
+		if (indices.computeFamily.has_value()) {
+			uniqueQueueFamilies.insert(indices.computeFamily.value());
+		}
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -31,14 +49,99 @@ namespace basicvk {
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
-		VkPhysicalDeviceFeatures deviceFeatures{};
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevicePtr->getVkPhysicalDevice(), &properties);
+		//the 1.2 and 1.3 feature structs can only be chained when the device exposes that version
+		bool hasVulkan12 = properties.apiVersion >= VK_API_VERSION_1_2;
+		bool hasVulkan13 = properties.apiVersion >= VK_API_VERSION_1_3;
+
+		VkPhysicalDeviceVulkan13Features supportedFeatures13{};
+		supportedFeatures13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+		supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		supportedFeatures12.pNext = hasVulkan13 ? &supportedFeatures13 : nullptr;
+		VkPhysicalDeviceFeatures2 supportedFeatures2{};
+		supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures2.pNext = hasVulkan12 ? &supportedFeatures12 : nullptr;
+#ifdef VK_EXT_descriptor_buffer
+		VkPhysicalDeviceDescriptorBufferFeaturesEXT supportedDescriptorBuffer{};
+		supportedDescriptorBuffer.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+		if (hasDescriptorBuffer) {
+			supportedDescriptorBuffer.pNext = supportedFeatures2.pNext;
+			supportedFeatures2.pNext = &supportedDescriptorBuffer;
+		}
+#endif
+		vkGetPhysicalDeviceFeatures2(physicalDevicePtr->getVkPhysicalDevice(), &supportedFeatures2);
+		const VkPhysicalDeviceFeatures& supportedFeatures = supportedFeatures2.features;
+
+		features.multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+		features.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+		features.drawIndirectCount = hasVulkan12 && supportedFeatures12.drawIndirectCount == VK_TRUE;
+		features.timelineSemaphore = hasVulkan12 && supportedFeatures12.timelineSemaphore == VK_TRUE;
+		features.synchronization2 = hasVulkan13 && supportedFeatures13.synchronization2 == VK_TRUE;
+		features.dynamicRendering = hasVulkan13 && supportedFeatures13.dynamicRendering == VK_TRUE;
+		features.descriptorIndexing = hasVulkan12 && supportedFeatures12.descriptorIndexing == VK_TRUE
+			&& supportedFeatures12.runtimeDescriptorArray == VK_TRUE
+			&& supportedFeatures12.descriptorBindingPartiallyBound == VK_TRUE
+			&& supportedFeatures12.descriptorBindingVariableDescriptorCount == VK_TRUE
+			&& supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+			&& supportedFeatures12.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE
+			&& supportedFeatures12.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+			&& supportedFeatures12.shaderStorageBufferArrayNonUniformIndexing == VK_TRUE;
+		features.bufferDeviceAddress = hasVulkan12 && supportedFeatures12.bufferDeviceAddress == VK_TRUE;
+#ifdef VK_EXT_descriptor_buffer
+		//descriptor buffers are bound through their device address
+		features.descriptorBuffer = hasDescriptorBuffer && features.bufferDeviceAddress && supportedDescriptorBuffer.descriptorBuffer == VK_TRUE;
+#endif
+
+		VkPhysicalDeviceVulkan13Features deviceFeatures13{};
+		deviceFeatures13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		deviceFeatures13.synchronization2 = features.synchronization2;
+		deviceFeatures13.dynamicRendering = features.dynamicRendering;
+
+		VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+		deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		deviceFeatures12.pNext = hasVulkan13 ? &deviceFeatures13 : nullptr;
+		deviceFeatures12.drawIndirectCount = features.drawIndirectCount;
+		deviceFeatures12.timelineSemaphore = features.timelineSemaphore;
+		deviceFeatures12.descriptorIndexing = features.descriptorIndexing;
+		deviceFeatures12.runtimeDescriptorArray = features.descriptorIndexing;
+		deviceFeatures12.descriptorBindingPartiallyBound = features.descriptorIndexing;
+		deviceFeatures12.descriptorBindingVariableDescriptorCount = features.descriptorIndexing;
+		deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind = features.descriptorIndexing;
+		deviceFeatures12.descriptorBindingStorageBufferUpdateAfterBind = features.descriptorIndexing;
+		deviceFeatures12.shaderSampledImageArrayNonUniformIndexing = features.descriptorIndexing;
+		deviceFeatures12.shaderStorageBufferArrayNonUniformIndexing = features.descriptorIndexing;
+		deviceFeatures12.bufferDeviceAddress = features.bufferDeviceAddress;
+
+		VkPhysicalDeviceFeatures2 deviceFeatures2{};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = hasVulkan12 ? &deviceFeatures12 : nullptr;
+#ifdef VK_EXT_descriptor_buffer
+		VkPhysicalDeviceDescriptorBufferFeaturesEXT deviceDescriptorBuffer{};
+		deviceDescriptorBuffer.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+		deviceDescriptorBuffer.descriptorBuffer = VK_TRUE;
+		if (features.descriptorBuffer) {
+			deviceDescriptorBuffer.pNext = deviceFeatures2.pNext;
+			deviceFeatures2.pNext = &deviceDescriptorBuffer;
+			deviceExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+		}
+#endif
+		VkPhysicalDeviceFeatures& deviceFeatures = deviceFeatures2.features;
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+		deviceFeatures.shaderStorageImageArrayDynamicIndexing = supportedFeatures.shaderStorageImageArrayDynamicIndexing;
+		deviceFeatures.shaderStorageImageReadWithoutFormat = supportedFeatures.shaderStorageImageReadWithoutFormat;
+		deviceFeatures.shaderStorageImageWriteWithoutFormat = supportedFeatures.shaderStorageImageWriteWithoutFormat;
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
-		createInfo.pEnabledFeatures = &deviceFeatures;
+		createInfo.pNext = &deviceFeatures2;
+		createInfo.pEnabledFeatures = nullptr;
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -50,16 +153,22 @@ namespace basicvk {
 		{
 			throw std::runtime_error("failed to create logical device!");
 		}
+
+		memoryAllocator = std::make_unique<MemoryAllocator>(device, physicalDevice, features.bufferDeviceAddress);
+		samplerCache = std::make_unique<SamplerCache>(device, physicalDevice);
 	}
 	Device::~Device()
 	{
 		if (device != VK_NULL_HANDLE) {
+			samplerCache.reset();
+			memoryAllocator.reset();
 			vkDestroyDevice(device, nullptr);
 			device = VK_NULL_HANDLE;
 		}
 	}
 	Device::Device(Device& other)
-		: physicalDevice(other.physicalDevice), device(other.device)
+		: physicalDevice(other.physicalDevice), device(other.device), features(other.features), memoryAllocator(std::move(other.memoryAllocator))
+		, samplerCache(std::move(other.samplerCache))
 	{
 		other.device = VK_NULL_HANDLE;
 	}
@@ -110,10 +219,50 @@ namespace basicvk {
 			return Queue();	//nullptr queue
 		}
 	}
+	Queue Device::getTransferQueue() const
+	{
+		QueueFamilyIndices indices = physicalDevice->getQueueFamillyIndices();
+		if (indices.transferFamily.has_value()) {
+			uint32_t indice = indices.transferFamily.value();
+			VkQueue transferQueue;
+			vkGetDeviceQueue(device, indice, 0, &transferQueue);
+
+			return Queue(transferQueue, indice);
+		}
+		else {
+			return getGraphicQueue();
+		}
+	}
+	Queue Device::getComputeQueue() const
+	{
+		QueueFamilyIndices indices = physicalDevice->getQueueFamillyIndices();
+		if (indices.computeFamily.has_value()) {
+			uint32_t indice = indices.computeFamily.value();
+			VkQueue computeQueue;
+			vkGetDeviceQueue(device, indice, 0, &computeQueue);
+
+			return Queue(computeQueue, indice);
+		}
+		else {
+			return getGraphicQueue();
+		}
+	}
 	std::shared_ptr<PhysicalDevice> Device::getPhysicalDevice() const
 	{
 		return physicalDevice;
 	}
+	MemoryAllocator& Device::getMemoryAllocator() const
+	{
+		return *memoryAllocator;
+	}
+	SamplerCache& Device::getSamplerCache() const
+	{
+		return *samplerCache;
+	}
+	const DeviceFeatures& Device::getFeatures() const
+	{
+		return features;
+	}
 	Queue::Queue()
 		: Queue(nullptr, -1)
 	{
@@ -0,0 +1,62 @@
+#include <FrameAllocator.hpp>
+#include <algorithm>
+
+namespace basicvk {
+	FrameAllocator::FrameAllocator(std::shared_ptr<Device> device, FrameAllocatorOptions options)
+		: device_ptr(device), buffers(), bufferSize(options.bufferSize), alignment(1), currentFrame(0), head(0)
+	{
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
+		if (options.usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+			alignment = std::max<uint64_t>(alignment, properties.limits.minUniformBufferOffsetAlignment);
+		}
+		if (options.usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+			alignment = std::max<uint64_t>(alignment, properties.limits.minStorageBufferOffsetAlignment);
+		}
+
+		BufferOptions bufferOptions{};
+		bufferOptions.usage = options.usage;
+		bufferOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		bufferOptions.memoryUsage = MemoryUsage::Dynamic;
+		for (uint32_t i = 0; i < options.frameCount; i++) {
+			buffers.push_back(std::make_unique<Buffer>(device, bufferOptions, bufferSize));
+		}
+	}
+	FrameAllocator::~FrameAllocator()
+	{
+	}
+	void FrameAllocator::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex;
+		head = 0;
+	}
+	TransientAllocation FrameAllocator::allocate(uint64_t size)
+	{
+		uint64_t offset = (head + alignment - 1) / alignment * alignment;
+		if (offset + size > bufferSize) {
+			throw std::runtime_error("frame allocator is out of memory");
+		}
+		head = offset + size;
+
+		Buffer& buffer = *buffers[currentFrame];
+		TransientAllocation allocation{};
+		allocation.buffer = &buffer;
+		allocation.offset = static_cast<uint32_t>(offset);
+		allocation.data = static_cast<char*>(buffer.getMappedData()) + offset;
+		return allocation;
+	}
+	void FrameAllocator::flush() const
+	{
+		if (head > 0) {
+			buffers[currentFrame]->flush(0, head);
+		}
+	}
+	const Buffer& FrameAllocator::getBuffer(uint32_t frameIndex) const
+	{
+		return *buffers[frameIndex];
+	}
+	uint64_t FrameAllocator::getAlignment() const
+	{
+		return alignment;
+	}
+}
@@ -4,6 +4,9 @@ namespace basicvk {
 	Framebuffer::Framebuffer(std::shared_ptr<Device> device, const Swapchain& swapchain, const GraphicPipeline& graphicPipeline)
 		: device_ptr(device), swapChainFramebuffers()
 	{
+		if (graphicPipeline.getVkRenderPass() == VK_NULL_HANDLE) {
+			throw std::invalid_argument("pipelines using dynamic rendering have no framebuffer");
+		}
 		const std::vector<VkImageView>& swapChainImageViews = swapchain.getVkSwapchainImageViews();
 		VkExtent2D swapChainExtent = swapchain.getVkSwapChainExtent();
 		swapChainFramebuffers.resize(swapChainImageViews.size(), VK_NULL_HANDLE);
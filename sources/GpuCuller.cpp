@@ -0,0 +1,398 @@
+#include <GpuCuller.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace basicvk {
+	//std140 layout of the Params block of shaders/cull.comp
+	struct CullParams {
+		float frustumPlanes[6][4];
+		float previousViewProjection[16];
+		uint32_t objectCount;
+		uint32_t occlusionEnabled;
+		uint32_t compact;
+		uint32_t hiZLevels;
+		float hiZSize[2];
+		uint32_t objectIndexAsInstance;
+		uint32_t padding;
+	};
+
+	struct HiZParams {
+		uint32_t level;
+	};
+
+	static void extractFrustumPlanes(const float m[16], float planes[6][4])
+	{
+		//rows of the column major matrix, planes point inside the frustum
+		for (int i = 0; i < 4; i++) {
+			float row0 = m[i * 4 + 0];
+			float row1 = m[i * 4 + 1];
+			float row2 = m[i * 4 + 2];
+			float row3 = m[i * 4 + 3];
+			planes[0][i] = row3 + row0;	//left
+			planes[1][i] = row3 - row0;	//right
+			planes[2][i] = row3 + row1;	//bottom
+			planes[3][i] = row3 - row1;	//top
+			planes[4][i] = row2;	//near, depth is 0..1
+			planes[5][i] = row3 - row2;	//far
+		}
+		for (int i = 0; i < 6; i++) {
+			float length = std::sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+			if (length > 0.0f) {
+				for (int j = 0; j < 4; j++) {
+					planes[i][j] /= length;
+				}
+			}
+		}
+	}
+
+	GpuCuller::GpuCuller(std::shared_ptr<Device> device, const GraphicPipeline& graphicPipeline, const Swapchain& swapchain, GpuCullerOptions options)
+		: device_ptr(device), options(options), depthBuffer(), depthAspect(0)
+		, occlusionSupported(false), compact(device->getFeatures().drawIndirectCount)
+		, cullSetLayout(device, {
+			{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1 },
+			{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1 },
+			{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1 },
+			{ 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1 },
+			{ 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1 } })
+		, hiZSetLayout(device, {
+			{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1 },
+			{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1 },
+			{ 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 1 } })
+		, descriptorPool(device, DescriptorPoolCreateInfo{ {
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, options.frameCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * options.frameCount },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, options.frameCount + MAX_HIZ_LEVELS },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * MAX_HIZ_LEVELS } }, options.frameCount + MAX_HIZ_LEVELS })
+		, cullPipeline(device, Shader(device, options.cullShaderPath), ComputePipelineInfo{ { &cullSetLayout }, {} })
+		, hiZPipeline(device, Shader(device, options.hiZShaderPath), ComputePipelineInfo{
+			{ &hiZSetLayout },
+			{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZParams) } } })
+		, objectBuffer(), paramsBuffer(), paramsStride(0), hiZ(), hiZLevelViews(), hiZDescriptorSets(), frames(options.frameCount)
+		, objectCount(0), currentFrame(0), viewProjection(), hiZViewProjection(), hiZValid(false)
+	{
+		if (options.frameCount == 0) {
+			throw std::invalid_argument("gpu culler needs at least one frame");
+		}
+
+		//occlusion needs to sample the depth buffer, frustum culling works without it
+		VkFormatProperties depthProperties{};
+		vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice()->getVkPhysicalDevice(), device->getPhysicalDevice()->findDepthFormat(), &depthProperties);
+		occlusionSupported = (depthProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+
+		BufferOptions objectOptions{};
+		objectOptions.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		objectOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		objectOptions.memoryUsage = MemoryUsage::GpuOnly;
+		objectBuffer = std::make_unique<Buffer>(device, objectOptions, static_cast<uint64_t>(options.maxObjects) * sizeof(CullObject));
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
+		uint64_t uniformAlignment = std::max<uint64_t>(1, properties.limits.minUniformBufferOffsetAlignment);
+		paramsStride = (sizeof(CullParams) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+
+		BufferOptions paramsOptions{};
+		paramsOptions.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		paramsOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		paramsOptions.memoryUsage = MemoryUsage::Upload;
+		paramsBuffer = std::make_unique<Buffer>(device, paramsOptions, paramsStride * options.frameCount);
+
+		//written by createHiZ, which recreates the pyramid when the depth buffer changes
+		for (uint32_t level = 0; level < MAX_HIZ_LEVELS; level++) {
+			hiZDescriptorSets.push_back(descriptorPool.allocateDescriptorSet(hiZSetLayout));
+		}
+
+		BufferOptions drawOptions{};
+		drawOptions.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		drawOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		drawOptions.memoryUsage = MemoryUsage::GpuOnly;
+		for (uint32_t i = 0; i < options.frameCount; i++) {
+			FrameResources& frame = frames[i];
+			frame.drawBuffer = std::make_unique<Buffer>(device, drawOptions, static_cast<uint64_t>(options.maxObjects) * sizeof(VkDrawIndexedIndirectCommand));
+			frame.countBuffer = std::make_unique<Buffer>(device, drawOptions, sizeof(uint32_t));
+			frame.descriptorSet = descriptorPool.allocateDescriptorSet(cullSetLayout);
+
+			BufferUpdateInfo paramsInfo{};
+			paramsInfo.buffer = paramsBuffer->getVkBuffer();
+			paramsInfo.offset = i * paramsStride;
+			paramsInfo.range = sizeof(CullParams);
+			paramsInfo.binding = 0;
+			paramsInfo.arrayElement = 0;
+			paramsInfo.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+			BufferUpdateInfo objectInfo{};
+			objectInfo.buffer = objectBuffer->getVkBuffer();
+			objectInfo.offset = 0;
+			objectInfo.range = VK_WHOLE_SIZE;
+			objectInfo.binding = 1;
+			objectInfo.arrayElement = 0;
+			objectInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+			BufferUpdateInfo drawInfo = objectInfo;
+			drawInfo.buffer = frame.drawBuffer->getVkBuffer();
+			drawInfo.binding = 2;
+
+			BufferUpdateInfo countInfo = objectInfo;
+			countInfo.buffer = frame.countBuffer->getVkBuffer();
+			countInfo.binding = 3;
+
+			DescriptorSetUpdateInfo updateInfo{};
+			updateInfo.bufferInfos = { paramsInfo, objectInfo, drawInfo, countInfo };
+			frame.descriptorSet->UpdateDescriptorSet(updateInfo);
+		}
+
+		createHiZ(graphicPipeline, swapchain);
+	}
+	GpuCuller::~GpuCuller()
+	{
+		destroyHiZ();
+	}
+	CullObject GpuCuller::makeObject(const MeshRange& mesh, const float center[3], float radius)
+	{
+		CullObject object{};
+		object.center[0] = center[0];
+		object.center[1] = center[1];
+		object.center[2] = center[2];
+		object.radius = radius;
+		object.indexCount = mesh.indexCount;
+		object.firstIndex = mesh.firstIndex;
+		object.vertexOffset = mesh.vertexOffset;
+		return object;
+	}
+	uint32_t GpuCuller::addObjects(UploadManager& uploadManager, const std::vector<CullObject>& objects)
+	{
+		if (objects.size() > options.maxObjects - objectCount) {
+			throw std::runtime_error("gpu culler is full");
+		}
+		uint32_t first = objectCount;
+		uploadManager.uploadBuffer(*objectBuffer, objects.data(), objects.size() * sizeof(CullObject), static_cast<uint64_t>(first) * sizeof(CullObject));
+		objectCount += static_cast<uint32_t>(objects.size());
+		return first;
+	}
+	void GpuCuller::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex % options.frameCount;
+	}
+	void GpuCuller::cull(const CommandBuffer& commandBuffer, const float cameraViewProjection[16])
+	{
+		std::memcpy(viewProjection, cameraViewProjection, sizeof(viewProjection));
+
+		CullParams params{};
+		extractFrustumPlanes(viewProjection, params.frustumPlanes);
+		std::memcpy(params.previousViewProjection, hiZViewProjection, sizeof(hiZViewProjection));
+		params.objectCount = objectCount;
+		params.occlusionEnabled = hiZValid ? 1 : 0;
+		params.compact = compact ? 1 : 0;
+		params.hiZLevels = hiZ->getMipLevels();
+		params.hiZSize[0] = static_cast<float>(hiZ->getWidth());
+		params.hiZSize[1] = static_cast<float>(hiZ->getHeight());
+		params.objectIndexAsInstance = device_ptr->getFeatures().drawIndirectFirstInstance ? 1 : 0;
+		paramsBuffer->write(&params, sizeof(params), currentFrame * paramsStride);
+
+		FrameResources& frame = frames[currentFrame];
+
+		if (compact) {
+			commandBuffer.fillBuffer(*frame.countBuffer, 0);
+			commandBuffer.bufferBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+				{ frame.countBuffer.get(), VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT } });
+		}
+
+		//the hierarchical depth is read as GENERAL, the first read also gives it that layout
+		commandBuffer.requireAccess(*hiZ, ResourceAccess::ComputeStorageRead);
+
+		commandBuffer.bindComputePipeline(cullPipeline);
+		commandBuffer.bindComputeDescriptorSet(cullPipeline, frame.descriptorSet);
+		commandBuffer.dispatch((objectCount + 63) / 64, 1, 1);
+
+		commandBuffer.bufferBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, {
+			{ frame.drawBuffer.get(), VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT },
+			{ frame.countBuffer.get(), VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT } });
+	}
+	void GpuCuller::draw(const CommandBuffer& commandBuffer, const Swapchain& swapchain) const
+	{
+		const FrameResources& frame = frames[currentFrame];
+		if (compact) {
+			commandBuffer.drawIndexedIndirectCount(swapchain, *frame.drawBuffer, 0, *frame.countBuffer, 0, objectCount);
+		}
+		else if (device_ptr->getFeatures().multiDrawIndirect) {
+			commandBuffer.drawIndexedIndirect(swapchain, *frame.drawBuffer, 0, objectCount);
+		}
+		else {
+			for (uint32_t i = 0; i < objectCount; i++) {
+				commandBuffer.drawIndexedIndirect(swapchain, *frame.drawBuffer, static_cast<VkDeviceSize>(i) * sizeof(VkDrawIndexedIndirectCommand), 1);
+			}
+		}
+	}
+	void GpuCuller::buildHiZ(const CommandBuffer& commandBuffer)
+	{
+		if (!occlusionSupported) {
+			return;
+		}
+
+		//the render pass wrote the depth outside of the tracker, its state starts from that write
+		ResourceState depthState{};
+		depthState.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthState.writeStageMask = getAccessInfo(ResourceAccess::DepthAttachmentWrite).stageMask;
+		depthState.writeAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		commandBuffer.requireAccess(depthBuffer.depthImage, depthAspect, depthState, ResourceAccess::DepthAttachmentRead);
+
+		commandBuffer.bindComputePipeline(hiZPipeline);
+		uint32_t levelWidth = hiZ->getWidth();
+		uint32_t levelHeight = hiZ->getHeight();
+		for (uint32_t level = 0; level < hiZ->getMipLevels(); level++) {
+			//the next level reads this one, the write of level 0 also waits for the reads of this frame's culling
+			if (level > 0) {
+				commandBuffer.requireAccess(*hiZ, ResourceAccess::ComputeStorageRead, level - 1, 1);
+			}
+			commandBuffer.requireAccess(*hiZ, ResourceAccess::ComputeStorageWrite, level, 1);
+
+			HiZParams params{};
+			params.level = level;
+			commandBuffer.bindComputeDescriptorSet(hiZPipeline, hiZDescriptorSets[level]);
+			commandBuffer.pushConstants(hiZPipeline, params);
+			commandBuffer.dispatch((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+
+			levelWidth = std::max(1u, levelWidth / 2);
+			levelHeight = std::max(1u, levelHeight / 2);
+		}
+
+		//back to the attachment layout before the next render pass clears it. flushed here, the attachment barrier
+		//of the next beginRendering starts from UNDEFINED and can't share a batch with this one
+		commandBuffer.requireAccess(depthBuffer.depthImage, depthAspect, depthState, ResourceAccess::DepthAttachmentWrite);
+		commandBuffer.flushBarriers();
+
+		std::memcpy(hiZViewProjection, viewProjection, sizeof(viewProjection));
+		hiZValid = true;
+	}
+	void GpuCuller::resize(const GraphicPipeline& graphicPipeline, const Swapchain& swapchain)
+	{
+		destroyHiZ();
+		createHiZ(graphicPipeline, swapchain);
+	}
+	bool GpuCuller::isOcclusionSupported() const
+	{
+		return occlusionSupported;
+	}
+	uint32_t GpuCuller::getObjectCount() const
+	{
+		return objectCount;
+	}
+	const Buffer& GpuCuller::getDrawBuffer(uint32_t frameIndex) const
+	{
+		return *frames[frameIndex % options.frameCount].drawBuffer;
+	}
+	void GpuCuller::createHiZ(const GraphicPipeline& graphicPipeline, const Swapchain& swapchain)
+	{
+		if (graphicPipeline.getDepthStoreOp() != VK_ATTACHMENT_STORE_OP_STORE) {
+			throw std::invalid_argument("the hierarchical depth needs a pipeline storing its depth");
+		}
+		depthBuffer = graphicPipeline.getDepthBuffer();
+		depthAspect = getImageAspectMask(graphicPipeline.getDepthFormat());
+
+		//level 0 is half the depth buffer, every level halves the previous one rounding down
+		VkExtent2D depthExtent = swapchain.getVkSwapChainExtent();
+		uint32_t hiZWidth = std::max(1u, depthExtent.width / 2);
+		uint32_t hiZHeight = std::max(1u, depthExtent.height / 2);
+		uint32_t hiZLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(hiZWidth, hiZHeight)))) + 1;
+		if (hiZLevels > MAX_HIZ_LEVELS) {
+			throw std::runtime_error("depth buffer is too large for the hierarchical depth pyramid");
+		}
+
+		TextureOptions hiZOptions{};
+		hiZOptions.width = hiZWidth;
+		hiZOptions.height = hiZHeight;
+		hiZOptions.format = VK_FORMAT_R32_SFLOAT;
+		hiZOptions.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		hiZOptions.tiling = VK_IMAGE_TILING_OPTIMAL;
+		hiZOptions.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		hiZOptions.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		hiZOptions.useMimaping = false;
+		hiZOptions.mipLevels = hiZLevels;
+		hiZOptions.sampler.magFilter = VK_FILTER_NEAREST;
+		hiZOptions.sampler.minFilter = VK_FILTER_NEAREST;
+		hiZOptions.sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		hiZOptions.sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		hiZOptions.sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		hiZOptions.sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		hiZOptions.sampler.anisotropyEnable = false;
+		hiZ = std::make_unique<Texture>(device_ptr, hiZOptions);
+
+		for (uint32_t level = 0; level < hiZLevels; level++) {
+			hiZLevelViews.push_back(createLevelView(level));
+		}
+
+		//level 0 reads the depth buffer, the others the level above them
+		for (uint32_t level = 0; level < hiZLevels; level++) {
+			std::shared_ptr<DescriptorSet> descriptorSet = hiZDescriptorSets[level];
+
+			TextureUpdateInfo depthInfo{};
+			depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			depthInfo.imageView = depthBuffer.depthImageView;
+			depthInfo.sampler = hiZ->getVkSampler();
+			depthInfo.binding = 0;
+			depthInfo.arrayElement = 0;
+
+			TextureUpdateInfo srcInfo{};
+			srcInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			srcInfo.imageView = hiZLevelViews[level == 0 ? 0 : level - 1];
+			srcInfo.sampler = VK_NULL_HANDLE;
+			srcInfo.binding = 1;
+			srcInfo.arrayElement = 0;
+			srcInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+			TextureUpdateInfo dstInfo = srcInfo;
+			dstInfo.imageView = hiZLevelViews[level];
+			dstInfo.binding = 2;
+
+			DescriptorSetUpdateInfo updateInfo{};
+			updateInfo.textureInfos = { srcInfo, dstInfo };
+			if (occlusionSupported) {
+				updateInfo.textureInfos.push_back(depthInfo);
+			}
+			descriptorSet->UpdateDescriptorSet(updateInfo);
+		}
+
+		TextureUpdateInfo hiZInfo{};
+		hiZInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		hiZInfo.imageView = hiZ->getVkImageView();
+		hiZInfo.sampler = hiZ->getVkSampler();
+		hiZInfo.binding = 4;
+		hiZInfo.arrayElement = 0;
+
+		DescriptorSetUpdateInfo updateInfo{};
+		updateInfo.textureInfos = { hiZInfo };
+		for (auto& frame : frames) {
+			frame.descriptorSet->UpdateDescriptorSet(updateInfo);
+		}
+
+		//the new pyramid needs its layout and holds nothing the next cull could test against
+		hiZValid = false;
+	}
+	void GpuCuller::destroyHiZ()
+	{
+		for (VkImageView view : hiZLevelViews) {
+			vkDestroyImageView(device_ptr->getVkDevice(), view, VK_NULL_HANDLE);
+		}
+		hiZLevelViews.clear();
+		hiZ.reset();
+	}
+	VkImageView GpuCuller::createLevelView(uint32_t level) const
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = hiZ->getVkImage();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = level;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView view;
+		if (vkCreateImageView(device_ptr->getVkDevice(), &viewInfo, VK_NULL_HANDLE, &view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create storage image view!");
+		}
+		return view;
+	}
+}
@@ -1,21 +1,10 @@
 #include <GraphicPipeline.hpp>
+#include <ResourceState.hpp>
 
 namespace basicvk {
-	GraphicPipeline::GraphicPipeline(std::shared_ptr<Device> device, const Swapchain& swapchain, const Shader& shader, GraphicPipelineInfo pipelineInfo)
-		: device_ptr(device), graphicPipeline(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE)
-		, renderPass(VK_NULL_HANDLE), depthBuffer({})
+	static VkRenderPass createRenderPass(VkDevice device, VkFormat colorFormat, VkFormat depthFormat, VkAttachmentStoreOp depthStoreOp)
 	{
-		VkDescriptorSetLayout vkDescriptorSetLayout = pipelineInfo.descriptorSetLayout ? pipelineInfo.descriptorSetLayout->getVkDescriptorSetLayout() : VK_NULL_HANDLE;
-		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCreateInfo.setLayoutCount = pipelineInfo.descriptorSetLayout ? 1 : 0;
-		pipelineLayoutCreateInfo.pSetLayouts = &vkDescriptorSetLayout;
-		pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-		pipelineLayoutCreateInfo.pPushConstantRanges = VK_NULL_HANDLE;
-		if (vkCreatePipelineLayout(device->getVkDevice(), &pipelineLayoutCreateInfo, VK_NULL_HANDLE, &pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("unable to create pipline layout");
-		}
-
+		VkRenderPass renderPass;
 		VkSubpassDependency dependency{};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.dstSubpass = 0;
@@ -25,7 +14,7 @@ namespace basicvk {
 		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
 		VkAttachmentDescription colorAttachment{};
-		colorAttachment.format = swapchain.getVkSwapChainImageFormat();
+		colorAttachment.format = colorFormat;
 		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -39,10 +28,10 @@ namespace basicvk {
 		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentDescription depthAttachment{};
-		depthAttachment.format = device_ptr->getPhysicalDevice()->findDepthFormat();
+		depthAttachment.format = depthFormat;
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.storeOp = depthStoreOp;
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -67,9 +56,45 @@ namespace basicvk {
 		renderPassCreateInfo.pSubpasses = &subpass;
 		renderPassCreateInfo.dependencyCount = 1;
 		renderPassCreateInfo.pDependencies = &dependency;
-		if (vkCreateRenderPass(device->getVkDevice(), &renderPassCreateInfo, VK_NULL_HANDLE, &renderPass) != VK_SUCCESS) {
+		if (vkCreateRenderPass(device, &renderPassCreateInfo, VK_NULL_HANDLE, &renderPass) != VK_SUCCESS) {
 			throw std::runtime_error("unable to create render pass");
 		}
+		return renderPass;
+	}
+
+	GraphicPipeline::GraphicPipeline(std::shared_ptr<Device> device, const Swapchain& swapchain, const Shader& shader, GraphicPipelineInfo pipelineInfo)
+		: device_ptr(device), graphicPipeline(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE)
+		, renderPass(VK_NULL_HANDLE), colorFormat(swapchain.getVkSwapChainImageFormat())
+		, depthFormat(device->getPhysicalDevice()->findDepthFormat()), depthStoreOp(pipelineInfo.depthStoreOp), depthBuffer({})
+	{
+		VkDescriptorSetLayout vkDescriptorSetLayout = pipelineInfo.descriptorSetLayout ? pipelineInfo.descriptorSetLayout->getVkDescriptorSetLayout() : VK_NULL_HANDLE;
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCreateInfo.setLayoutCount = pipelineInfo.descriptorSetLayout ? 1 : 0;
+		pipelineLayoutCreateInfo.pSetLayouts = &vkDescriptorSetLayout;
+		pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pipelineInfo.pushConstantRanges.size());
+		pipelineLayoutCreateInfo.pPushConstantRanges = pipelineInfo.pushConstantRanges.data();
+		if (vkCreatePipelineLayout(device->getVkDevice(), &pipelineLayoutCreateInfo, VK_NULL_HANDLE, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("unable to create pipline layout");
+		}
+
+		VkPipelineRenderingCreateInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		if (pipelineInfo.dynamicRendering) {
+			if (!device->getFeatures().dynamicRendering) {
+				throw std::runtime_error("dynamic rendering is not supported by the device");
+			}
+			//only the attachment formats have to match at draw time, no render pass compatibility
+			renderingInfo.colorAttachmentCount = 1;
+			renderingInfo.pColorAttachmentFormats = &colorFormat;
+			renderingInfo.depthAttachmentFormat = depthFormat;
+			if (getImageAspectMask(depthFormat) & VK_IMAGE_ASPECT_STENCIL_BIT) {
+				renderingInfo.stencilAttachmentFormat = depthFormat;
+			}
+		}
+		else {
+			renderPass = createRenderPass(device->getVkDevice(), colorFormat, depthFormat, depthStoreOp);
+		}
 
 		std::vector<VkDynamicState> dynamicStates = {
 			VK_DYNAMIC_STATE_VIEWPORT,
@@ -178,6 +203,14 @@ namespace basicvk {
 		auto ShaderStageCreateInfo = shader.getPipelineShaderStageCreateInfo();
 		VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
 		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.pNext = pipelineInfo.dynamicRendering ? &renderingInfo : nullptr;
+#ifdef VK_EXT_descriptor_buffer
+		pipelineCreateInfo.flags = pipelineInfo.descriptorBuffer ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+#else
+		if (pipelineInfo.descriptorBuffer) {
+			throw std::runtime_error("descriptor buffers are not supported by the vulkan headers");
+		}
+#endif
 		pipelineCreateInfo.stageCount = static_cast<uint32_t>(ShaderStageCreateInfo.size());
 		pipelineCreateInfo.pStages = ShaderStageCreateInfo.data();
 		pipelineCreateInfo.pVertexInputState = &vertexInputInfo;
@@ -202,7 +235,6 @@ namespace basicvk {
 
 		///DEPTH BUFFER CREATION
 		VkExtent2D swapchainExtent = swapchain.getVkSwapChainExtent();
-		VkFormat depthFormat = device->getPhysicalDevice()->findDepthFormat();
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -215,6 +247,11 @@ namespace basicvk {
 		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		VkFormatProperties depthProperties{};
+		vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice()->getVkPhysicalDevice(), depthFormat, &depthProperties);
+		if (depthProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) {
+			imageInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -280,7 +317,8 @@ namespace basicvk {
 	}
 	GraphicPipeline::GraphicPipeline(GraphicPipeline& other)
 		: device_ptr(other.device_ptr), graphicPipeline(other.graphicPipeline)
-		, pipelineLayout(other.pipelineLayout), renderPass(other.renderPass), depthBuffer(other.depthBuffer)
+		, pipelineLayout(other.pipelineLayout), renderPass(other.renderPass), colorFormat(other.colorFormat)
+		, depthFormat(other.depthFormat), depthStoreOp(other.depthStoreOp), depthBuffer(other.depthBuffer)
 	{
 		other.graphicPipeline = VK_NULL_HANDLE;
 		other.pipelineLayout = VK_NULL_HANDLE;
@@ -295,6 +333,18 @@ namespace basicvk {
 	{
 		return renderPass;
 	}
+	VkFormat GraphicPipeline::getColorFormat() const
+	{
+		return colorFormat;
+	}
+	VkFormat GraphicPipeline::getDepthFormat() const
+	{
+		return depthFormat;
+	}
+	VkAttachmentStoreOp GraphicPipeline::getDepthStoreOp() const
+	{
+		return depthStoreOp;
+	}
 	VkPipeline GraphicPipeline::getVkGraphicPipeline() const
 	{
 		return graphicPipeline;
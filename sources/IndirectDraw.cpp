@@ -0,0 +1,146 @@
+#include <IndirectDraw.hpp>
+#include <algorithm>
+
+namespace basicvk {
+	static uint32_t getIndexSize(VkIndexType indexType)
+	{
+		switch (indexType) {
+		case VK_INDEX_TYPE_UINT16:
+			return 2;
+		case VK_INDEX_TYPE_UINT32:
+			return 4;
+		default:
+			throw std::invalid_argument("unsupported index type");
+		}
+	}
+
+	MeshPool::MeshPool(std::shared_ptr<Device> device, MeshPoolOptions options)
+		: device_ptr(device), options(options), indexSize(getIndexSize(options.indexType)), vertexBuffer(), indexBuffer(), vertexCount(0), indexCount(0)
+	{
+		BufferOptions vertexBufferOptions{};
+		vertexBufferOptions.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		vertexBufferOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		vertexBufferOptions.memoryUsage = MemoryUsage::GpuOnly;
+		vertexBuffer = std::make_unique<Buffer>(device, vertexBufferOptions, static_cast<uint64_t>(options.maxVertices) * options.vertexStride);
+
+		BufferOptions indexBufferOptions{};
+		indexBufferOptions.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		indexBufferOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		indexBufferOptions.memoryUsage = MemoryUsage::GpuOnly;
+		indexBuffer = std::make_unique<Buffer>(device, indexBufferOptions, static_cast<uint64_t>(options.maxIndices) * indexSize);
+	}
+	MeshRange MeshPool::addMesh(UploadManager& uploadManager, const void* vertices, uint32_t meshVertexCount, const void* indices, uint32_t meshIndexCount)
+	{
+		if (meshVertexCount > options.maxVertices - vertexCount || meshIndexCount > options.maxIndices - indexCount) {
+			throw std::runtime_error("mesh pool is full");
+		}
+
+		MeshRange range{};
+		range.firstIndex = indexCount;
+		range.indexCount = meshIndexCount;
+		range.vertexOffset = static_cast<int32_t>(vertexCount);
+
+		uploadManager.uploadBuffer(*vertexBuffer, vertices, static_cast<uint64_t>(meshVertexCount) * options.vertexStride, static_cast<uint64_t>(vertexCount) * options.vertexStride);
+		uploadManager.uploadBuffer(*indexBuffer, indices, static_cast<uint64_t>(meshIndexCount) * indexSize, static_cast<uint64_t>(indexCount) * indexSize);
+		vertexCount += meshVertexCount;
+		indexCount += meshIndexCount;
+		return range;
+	}
+	void MeshPool::bind(const CommandBuffer& commandBuffer) const
+	{
+		commandBuffer.bindVertexBuffer(*vertexBuffer);
+		commandBuffer.bindIndexBuffer(*indexBuffer, options.indexType);
+	}
+	const Buffer& MeshPool::getVertexBuffer() const
+	{
+		return *vertexBuffer;
+	}
+	const Buffer& MeshPool::getIndexBuffer() const
+	{
+		return *indexBuffer;
+	}
+	VkIndexType MeshPool::getIndexType() const
+	{
+		return options.indexType;
+	}
+	uint32_t MeshPool::getVertexCount() const
+	{
+		return vertexCount;
+	}
+	uint32_t MeshPool::getIndexCount() const
+	{
+		return indexCount;
+	}
+
+	IndirectDrawList::IndirectDrawList(std::shared_ptr<Device> device, IndirectDrawListOptions options)
+		: device_ptr(device), options(options), buffers(), commands(), maxDrawIndirectCount(1), currentFrame(0), drawCount(0)
+	{
+		if (options.frameCount == 0) {
+			throw std::invalid_argument("indirect draw list needs at least one frame");
+		}
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
+		if (device->getFeatures().multiDrawIndirect) {
+			maxDrawIndirectCount = std::max(1u, properties.limits.maxDrawIndirectCount);
+		}
+
+		BufferOptions bufferOptions{};
+		bufferOptions.usage = options.usage;
+		bufferOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		bufferOptions.memoryUsage = MemoryUsage::Upload;
+		for (uint32_t i = 0; i < options.frameCount; i++) {
+			buffers.push_back(std::make_unique<Buffer>(device, bufferOptions, static_cast<uint64_t>(options.maxDraws) * sizeof(VkDrawIndexedIndirectCommand)));
+			commands.push_back(buffers.back()->getMappedSpan<VkDrawIndexedIndirectCommand>());
+		}
+	}
+	void IndirectDrawList::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex % options.frameCount;
+		drawCount = 0;
+	}
+	uint32_t IndirectDrawList::add(const MeshRange& mesh, uint32_t instanceCount, uint32_t firstInstance)
+	{
+		if (drawCount == options.maxDraws) {
+			throw std::runtime_error("indirect draw list is full");
+		}
+		if (firstInstance != 0 && !device_ptr->getFeatures().drawIndirectFirstInstance) {
+			throw std::runtime_error("draw indirect first instance is not supported by this device");
+		}
+
+		//written through the mapping, flush() then queues a single range for the whole list
+		VkDrawIndexedIndirectCommand& command = commands[currentFrame][drawCount];
+		command.indexCount = mesh.indexCount;
+		command.instanceCount = instanceCount;
+		command.firstIndex = mesh.firstIndex;
+		command.vertexOffset = mesh.vertexOffset;
+		command.firstInstance = firstInstance;
+		return drawCount++;
+	}
+	void IndirectDrawList::flush()
+	{
+		if (drawCount > 0) {
+			buffers[currentFrame]->flush(0, static_cast<uint64_t>(drawCount) * sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+	void IndirectDrawList::draw(const CommandBuffer& commandBuffer, const Swapchain& swapchain) const
+	{
+		//without multiDrawIndirect the limit is a single draw per call
+		for (uint32_t first = 0; first < drawCount; first += maxDrawIndirectCount) {
+			uint32_t count = std::min(maxDrawIndirectCount, drawCount - first);
+			commandBuffer.drawIndexedIndirect(swapchain, *buffers[currentFrame], static_cast<VkDeviceSize>(first) * sizeof(VkDrawIndexedIndirectCommand), count);
+		}
+	}
+	const Buffer& IndirectDrawList::getBuffer(uint32_t frameIndex) const
+	{
+		return *buffers[frameIndex % options.frameCount];
+	}
+	uint32_t IndirectDrawList::getDrawCount() const
+	{
+		return drawCount;
+	}
+	uint32_t IndirectDrawList::getMaxDraws() const
+	{
+		return options.maxDraws;
+	}
+}
@@ -0,0 +1,179 @@
+#include <MipmapGenerator.hpp>
+#include <algorithm>
+
+namespace basicvk {
+	struct DownsampleParams {
+		uint32_t mipCount;
+		uint32_t srgb;
+		uint32_t workGroupCount;
+	};
+
+	MipmapGenerator::MipmapGenerator(std::shared_ptr<Device> device, MipmapGeneratorOptions options)
+		: device_ptr(device)
+		, descriptorSetLayout(device, {
+			{ 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, MAX_MIP_LEVELS },
+			{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1 } })
+		, descriptorPool(device, DescriptorPoolCreateInfo{ {
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_MIP_LEVELS * options.maxTexturesPerBatch },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, options.maxTexturesPerBatch } }, options.maxTexturesPerBatch })
+		, pipeline(device, Shader(device, options.shaderPath), ComputePipelineInfo{
+			{ &descriptorSetLayout },
+			{ { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DownsampleParams) } } })
+		, counterBuffer(), counterStride(0)
+		, jobs(options.maxTexturesPerBatch), usedJobs(0), countersCleared(false)
+	{
+		//one atomic counter per texture of a batch, each at its own aligned offset
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice()->getVkPhysicalDevice(), &properties);
+		counterStride = std::max<uint64_t>(sizeof(uint32_t), properties.limits.minStorageBufferOffsetAlignment);
+
+		BufferOptions counterOptions{};
+		counterOptions.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		counterOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		counterOptions.memoryUsage = MemoryUsage::GpuOnly;
+		counterBuffer = std::make_unique<Buffer>(device, counterOptions, counterStride * options.maxTexturesPerBatch);
+
+		for (auto& job : jobs) {
+			job.descriptorSet = descriptorPool.allocateDescriptorSet(descriptorSetLayout);
+		}
+	}
+	MipmapGenerator::~MipmapGenerator()
+	{
+		reset();
+	}
+	VkImageUsageFlags MipmapGenerator::getRequiredImageUsage()
+	{
+		return VK_IMAGE_USAGE_STORAGE_BIT;
+	}
+	VkImageCreateFlags MipmapGenerator::getRequiredImageFlags(VkFormat format)
+	{
+		//srgb formats have no storage support, their levels are written through unorm views
+		if (getStorageFormat(format) != format) {
+			return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+		}
+		return 0;
+	}
+	bool MipmapGenerator::isSupported(VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels) const
+	{
+		if (mipLevels > MAX_MIP_LEVELS || std::max(width, height) > MAX_EXTENT) {
+			return false;
+		}
+
+		VkPhysicalDevice physicalDevice = device_ptr->getPhysicalDevice()->getVkPhysicalDevice();
+		VkPhysicalDeviceFeatures features{};
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		if (!features.shaderStorageImageReadWithoutFormat || !features.shaderStorageImageWriteWithoutFormat
+			|| !features.shaderStorageImageArrayDynamicIndexing) {
+			return false;
+		}
+
+		VkFormatProperties formatProperties{};
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, getStorageFormat(format), &formatProperties);
+		return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+	}
+	void MipmapGenerator::generate(const CommandBuffer& commandBuffer, Texture& texture)
+	{
+		//a single level has nothing to downsample, level 1 would alias the level 0 view
+		if (texture.getMipLevels() < 2) {
+			return;
+		}
+		if (!isSupported(texture.getVkFormat(), texture.getWidth(), texture.getHeight(), texture.getMipLevels())) {
+			throw std::runtime_error("texture can't be downsampled in a single pass");
+		}
+		if (usedJobs == jobs.size()) {
+			throw std::runtime_error("too many mipmap generations since the last reset");
+		}
+
+		uint32_t jobIndex = usedJobs++;
+		Job& job = jobs[jobIndex];
+		uint32_t mipLevels = texture.getMipLevels();
+		for (uint32_t i = 0; i < mipLevels; i++) {
+			job.views.push_back(createStorageView(texture, i));
+		}
+
+		//the array is always fully written, unused slots repeat the last level
+		DescriptorSetUpdateInfo updateInfo{};
+		for (uint32_t i = 0; i < MAX_MIP_LEVELS; i++) {
+			TextureUpdateInfo mipInfo{};
+			mipInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			mipInfo.imageView = job.views[std::min(i, mipLevels - 1)];
+			mipInfo.sampler = VK_NULL_HANDLE;
+			mipInfo.binding = 0;
+			mipInfo.arrayElement = i;
+			mipInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			updateInfo.textureInfos.push_back(mipInfo);
+		}
+		BufferUpdateInfo counterInfo{};
+		counterInfo.buffer = counterBuffer->getVkBuffer();
+		counterInfo.offset = jobIndex * counterStride;
+		counterInfo.range = sizeof(uint32_t);
+		counterInfo.binding = 1;
+		counterInfo.arrayElement = 0;
+		counterInfo.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		updateInfo.bufferInfos.push_back(counterInfo);
+		job.descriptorSet->UpdateDescriptorSet(updateInfo);
+
+		//the shader puts every counter back to zero when it is done, they only need clearing once
+		if (!countersCleared) {
+			commandBuffer.fillBuffer(*counterBuffer, 0);
+			commandBuffer.bufferBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+				{ counterBuffer.get(), VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT } });
+			countersCleared = true;
+		}
+
+		commandBuffer.requireAccess(texture, ResourceAccess::ComputeStorageReadWrite);
+
+		DownsampleParams params{};
+		params.mipCount = mipLevels;
+		params.srgb = getStorageFormat(texture.getVkFormat()) != texture.getVkFormat() ? 1 : 0;
+		uint32_t groupCountX = (texture.getWidth() + 63) / 64;
+		uint32_t groupCountY = (texture.getHeight() + 63) / 64;
+		params.workGroupCount = groupCountX * groupCountY;
+
+		commandBuffer.bindComputePipeline(pipeline);
+		commandBuffer.bindComputeDescriptorSet(pipeline, job.descriptorSet);
+		commandBuffer.pushConstants(pipeline, params);
+		commandBuffer.dispatch(groupCountX, groupCountY, 1);
+
+		//batched with the barriers of the next textures of the batch
+		commandBuffer.requireAccess(texture, ResourceAccess::FragmentSampledRead);
+	}
+	void MipmapGenerator::reset()
+	{
+		for (uint32_t i = 0; i < usedJobs; i++) {
+			for (VkImageView view : jobs[i].views) {
+				vkDestroyImageView(device_ptr->getVkDevice(), view, VK_NULL_HANDLE);
+			}
+			jobs[i].views.clear();
+		}
+		usedJobs = 0;
+	}
+	VkFormat MipmapGenerator::getStorageFormat(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+		case VK_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_UNORM;
+		case VK_FORMAT_A8B8G8R8_SRGB_PACK32: return VK_FORMAT_A8B8G8R8_UNORM_PACK32;
+		default: return format;
+		}
+	}
+	VkImageView MipmapGenerator::createStorageView(const Texture& texture, uint32_t mipLevel) const
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = texture.getVkImage();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = getStorageFormat(texture.getVkFormat());
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = mipLevel;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView view;
+		if (vkCreateImageView(device_ptr->getVkDevice(), &viewInfo, VK_NULL_HANDLE, &view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create storage image view!");
+		}
+		return view;
+	}
+}
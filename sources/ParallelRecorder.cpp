@@ -0,0 +1,79 @@
+#include <ParallelRecorder.hpp>
+#include <algorithm>
+#include <future>
+#include <thread>
+
+namespace basicvk {
+	static uint32_t getDefaultWorkerCount(uint32_t requested)
+	{
+		if (requested > 0) {
+			return requested;
+		}
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	ParallelRecorder::ParallelRecorder(std::shared_ptr<Device> device, Queue queue, ParallelRecorderOptions options)
+		: device_ptr(device), options(options), workerCount(getDefaultWorkerCount(options.workerCount)),
+		framePools(), currentFrame(0), threadPool(workerCount)
+	{
+		if (options.frameCount == 0) {
+			throw std::invalid_argument("parallel recorder needs at least one frame");
+		}
+
+		framePools.resize(options.frameCount);
+		for (auto& workerPools : framePools) {
+			for (uint32_t i = 0; i < workerCount; i++) {
+				workerPools.push_back(std::make_unique<CommandPool>(device, queue, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT));
+			}
+		}
+	}
+	ParallelRecorder::~ParallelRecorder()
+	{
+	}
+	void ParallelRecorder::beginFrame(uint32_t frameIndex)
+	{
+		currentFrame = frameIndex % options.frameCount;
+		for (auto& workerPool : framePools[currentFrame]) {
+			workerPool->reset();
+		}
+	}
+	void ParallelRecorder::record(const CommandBuffer& primary, const CommandBufferInheritance& inheritance, uint32_t drawCount, const RecordFunction& recordRange)
+	{
+		if (drawCount == 0) {
+			return;
+		}
+
+		uint32_t minDraws = std::max(1u, options.minDrawsPerWorker);
+		uint32_t taskCount = std::min(workerCount, (drawCount + minDraws - 1) / minDraws);
+		uint32_t drawsPerTask = (drawCount + taskCount - 1) / taskCount;
+
+		std::vector<std::shared_ptr<CommandBuffer>> secondaries(taskCount);
+		std::vector<std::future<void>> tasks;
+		tasks.reserve(taskCount);
+		for (uint32_t i = 0; i < taskCount; i++) {
+			uint32_t first = i * drawsPerTask;
+			uint32_t count = std::min(drawsPerTask, drawCount - first);
+			secondaries[i] = framePools[currentFrame][i]->acquireCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+			std::shared_ptr<CommandBuffer> secondary = secondaries[i];
+			tasks.push_back(threadPool.enqueue([secondary, inheritance, first, count, &recordRange]() {
+				secondary->beginCommandBuffer({ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT }, inheritance);
+				recordRange(*secondary, first, count);
+				secondary->endCommandBuffer();
+			}));
+		}
+
+		//every task has to finish before rethrowing, they reference recordRange
+		for (auto& task : tasks) {
+			task.wait();
+		}
+		for (auto& task : tasks) {
+			task.get();
+		}
+
+		primary.executeCommands(secondaries);
+	}
+	uint32_t ParallelRecorder::getWorkerCount() const
+	{
+		return workerCount;
+	}
+}
@@ -25,6 +25,16 @@ namespace basicvk {
 			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
 				queueFamilyIndices.graphicsFamily = i;
 			}
+			else if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
+				if (!queueFamilyIndices.computeFamily.has_value()) {
+					queueFamilyIndices.computeFamily = i;
+				}
+			}
+			else if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) {
+				if (!queueFamilyIndices.transferFamily.has_value()) {
+					queueFamilyIndices.transferFamily = i;
+				}
+			}
 
 			if (pWindow != nullptr) {
 				VkBool32 presentSupport = false;
@@ -32,8 +42,8 @@ namespace basicvk {
 				if (presentSupport) {
 					queueFamilyIndices.presentFamily = i;
 				}
-				i++;
 			}
+			i++;
 		}
 
 		if (!queueFamilyIndices.graphicsFamily.has_value()) {
@@ -0,0 +1,355 @@
+#include <RenderGraph.hpp>
+#include <algorithm>
+
+namespace basicvk {
+	static bool isRead(ResourceAccess access)
+	{
+		switch (access) {
+		case ResourceAccess::ComputeStorageWrite:
+		case ResourceAccess::ColorAttachmentWrite:
+		case ResourceAccess::DepthAttachmentWrite:
+		case ResourceAccess::TransferWrite:
+		case ResourceAccess::HostWrite:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	static VkImageUsageFlags getImageUsage(ResourceAccess access)
+	{
+		switch (access) {
+		case ResourceAccess::FragmentSampledRead:
+		case ResourceAccess::ComputeSampledRead:
+			return VK_IMAGE_USAGE_SAMPLED_BIT;
+		case ResourceAccess::ComputeStorageRead:
+		case ResourceAccess::ComputeStorageWrite:
+		case ResourceAccess::ComputeStorageReadWrite:
+			return VK_IMAGE_USAGE_STORAGE_BIT;
+		case ResourceAccess::ColorAttachmentWrite:
+			return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		case ResourceAccess::DepthAttachmentWrite:
+		case ResourceAccess::DepthAttachmentRead:
+			return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		case ResourceAccess::TransferRead:
+			return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		case ResourceAccess::TransferWrite:
+			return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		default:
+			throw std::invalid_argument("this access can't be used on a transient texture");
+		}
+	}
+
+	static TextureOptions getTransientOptions(const RenderGraphTextureDescription& description, VkImageUsageFlags usage)
+	{
+		TextureOptions options{};
+		options.width = description.width;
+		options.height = description.height;
+		options.format = description.format;
+		options.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		options.tiling = VK_IMAGE_TILING_OPTIMAL;
+		options.usage = usage;
+		options.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		options.useMimaping = false;
+		options.mipLevels = description.mipLevels;
+		return options;
+	}
+
+	RenderGraph::RenderGraph(std::shared_ptr<Device> device)
+		: device_ptr(device), unaliasedMemorySize(0), compiled(false)
+	{
+	}
+	RenderGraph::~RenderGraph()
+	{
+		destroyTransients();
+	}
+	uint32_t RenderGraph::createTexture(const std::string& name, RenderGraphTextureDescription description)
+	{
+		uint32_t id = addResource(name);
+		resources[id].description = description;
+		return id;
+	}
+	uint32_t RenderGraph::importTexture(const std::string& name, Texture& texture)
+	{
+		uint32_t id = addResource(name);
+		resources[id].texture = &texture;
+		resources[id].imported = true;
+		return id;
+	}
+	uint32_t RenderGraph::importBuffer(const std::string& name, const Buffer& buffer)
+	{
+		uint32_t id = addResource(name);
+		resources[id].buffer = &buffer;
+		resources[id].imported = true;
+		return id;
+	}
+	void RenderGraph::addPass(const std::string& name, std::vector<RenderGraphAccess> accesses, RenderGraphPassFunction record, bool sideEffects)
+	{
+		if (compiled) {
+			throw std::runtime_error("render graph is already compiled");
+		}
+		for (const auto& access : accesses) {
+			if (access.resource >= resources.size()) {
+				throw std::invalid_argument("unknown render graph resource");
+			}
+		}
+		passes.push_back({ name, std::move(accesses), std::move(record), sideEffects, false });
+	}
+	void RenderGraph::compile()
+	{
+		if (compiled) {
+			return;
+		}
+		cullPasses();
+		computeLifetimes();
+
+		std::vector<VkMemoryRequirements> requirements(resources.size());
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			Resource& resource = resources[i];
+			if (resource.imported || resource.firstPass == UINT32_MAX) {
+				continue;
+			}
+			requirements[i] = Texture::getMemoryRequirements(device_ptr, getTransientOptions(resource.description, resource.usage));
+		}
+		allocateTransients(requirements);
+		compiled = true;
+	}
+	void RenderGraph::execute(const CommandBuffer& commandBuffer)
+	{
+		if (!compiled) {
+			throw std::runtime_error("render graph is not compiled");
+		}
+
+		//the content of a transient does not survive execute, every time it starts over at its first pass
+		std::vector<bool> begun(resources.size());
+		for (uint32_t i = 0; i < passes.size(); i++) {
+			Pass& pass = passes[i];
+			if (pass.culled) {
+				continue;
+			}
+
+			for (const auto& access : pass.accesses) {
+				if (!resources[access.resource].imported && !begun[access.resource]) {
+					beginTransient(access.resource);
+					begun[access.resource] = true;
+				}
+			}
+
+			for (const auto& access : pass.accesses) {
+				Resource& resource = resources[access.resource];
+				if (resource.buffer != nullptr) {
+					commandBuffer.requireAccess(*resource.buffer, access.access);
+				}
+				else {
+					commandBuffer.requireAccess(*resource.texture, access.access);
+				}
+			}
+			//every barrier of the pass in one call, whatever the pass records first
+			commandBuffer.flushBarriers();
+			pass.record(commandBuffer, *this);
+		}
+	}
+	void RenderGraph::reset()
+	{
+		destroyTransients();
+		resources.clear();
+		resourceNames.clear();
+		passes.clear();
+		unaliasedMemorySize = 0;
+		compiled = false;
+	}
+	uint32_t RenderGraph::getResource(const std::string& name) const
+	{
+		auto it = resourceNames.find(name);
+		if (it == resourceNames.end()) {
+			throw std::invalid_argument("unknown render graph resource " + name);
+		}
+		return it->second;
+	}
+	Texture& RenderGraph::getTexture(uint32_t resource)
+	{
+		if (resource >= resources.size() || resources[resource].texture == nullptr) {
+			throw std::invalid_argument("render graph resource is not an allocated texture");
+		}
+		return *resources[resource].texture;
+	}
+	const Buffer& RenderGraph::getBuffer(uint32_t resource) const
+	{
+		if (resource >= resources.size() || resources[resource].buffer == nullptr) {
+			throw std::invalid_argument("render graph resource is not a buffer");
+		}
+		return *resources[resource].buffer;
+	}
+	uint32_t RenderGraph::getCulledPassCount() const
+	{
+		return static_cast<uint32_t>(std::count_if(passes.begin(), passes.end(), [](const Pass& pass) { return pass.culled; }));
+	}
+	VkDeviceSize RenderGraph::getTransientMemorySize() const
+	{
+		VkDeviceSize size = 0;
+		for (const auto& slot : slots) {
+			size += slot.requirements.size;
+		}
+		return size;
+	}
+	VkDeviceSize RenderGraph::getUnaliasedMemorySize() const
+	{
+		return unaliasedMemorySize;
+	}
+	uint32_t RenderGraph::addResource(const std::string& name)
+	{
+		if (compiled) {
+			throw std::runtime_error("render graph is already compiled");
+		}
+		if (resourceNames.count(name) != 0) {
+			throw std::invalid_argument("render graph resource " + name + " already exists");
+		}
+
+		Resource resource{};
+		resource.name = name;
+		resource.texture = nullptr;
+		resource.buffer = nullptr;
+		resource.imported = false;
+		resource.usage = 0;
+		resource.firstPass = UINT32_MAX;
+		resource.lastPass = 0;
+		resource.slot = UINT32_MAX;
+
+		uint32_t id = static_cast<uint32_t>(resources.size());
+		resources.push_back(std::move(resource));
+		resourceNames[name] = id;
+		return id;
+	}
+	void RenderGraph::cullPasses()
+	{
+		//walking backward, a pass is kept when it writes something that is imported or read by a kept pass
+		std::vector<bool> needed(resources.size());
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			needed[i] = resources[i].imported;
+		}
+
+		for (uint32_t i = static_cast<uint32_t>(passes.size()); i-- > 0;) {
+			Pass& pass = passes[i];
+			bool kept = pass.sideEffects;
+			for (const auto& access : pass.accesses) {
+				if (getAccessInfo(access.access).write && needed[access.resource]) {
+					kept = true;
+				}
+			}
+
+			pass.culled = !kept;
+			if (!kept) {
+				continue;
+			}
+			for (const auto& access : pass.accesses) {
+				if (isRead(access.access)) {
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+	void RenderGraph::computeLifetimes()
+	{
+		for (uint32_t i = 0; i < passes.size(); i++) {
+			if (passes[i].culled) {
+				continue;
+			}
+			for (const auto& access : passes[i].accesses) {
+				Resource& resource = resources[access.resource];
+				if (resource.imported) {
+					continue;
+				}
+				resource.firstPass = std::min(resource.firstPass, i);
+				resource.lastPass = std::max(resource.lastPass, i);
+				resource.usage |= getImageUsage(access.access);
+			}
+		}
+	}
+	void RenderGraph::allocateTransients(const std::vector<VkMemoryRequirements>& requirements)
+	{
+		std::vector<uint32_t> order;
+		for (uint32_t i = 0; i < resources.size(); i++) {
+			if (!resources[i].imported && resources[i].firstPass != UINT32_MAX) {
+				order.push_back(i);
+				unaliasedMemorySize += requirements[i].size;
+			}
+		}
+		//largest first, smaller transients then fill the slots they leave
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+		for (uint32_t id : order) {
+			Resource& resource = resources[id];
+			const VkMemoryRequirements& required = requirements[id];
+
+			MemorySlot* target = nullptr;
+			for (auto& slot : slots) {
+				if ((slot.requirements.memoryTypeBits & required.memoryTypeBits) == 0) {
+					continue;
+				}
+				bool overlaps = std::any_of(slot.resources.begin(), slot.resources.end(), [&](uint32_t other) {
+					return resources[other].firstPass <= resource.lastPass && resource.firstPass <= resources[other].lastPass;
+				});
+				if (!overlaps) {
+					target = &slot;
+					break;
+				}
+			}
+
+			if (target == nullptr) {
+				slots.push_back({ required, {}, {}, UINT32_MAX });
+				target = &slots.back();
+			}
+			else {
+				target->requirements.size = std::max(target->requirements.size, required.size);
+				target->requirements.alignment = std::max(target->requirements.alignment, required.alignment);
+				target->requirements.memoryTypeBits &= required.memoryTypeBits;
+			}
+			target->resources.push_back(id);
+			resource.slot = static_cast<uint32_t>(target - slots.data());
+		}
+
+		for (auto& slot : slots) {
+			slot.allocation = device_ptr->getMemoryAllocator().allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryResourceType::Optimal);
+			for (uint32_t id : slot.resources) {
+				Resource& resource = resources[id];
+				TextureOptions options = getTransientOptions(resource.description, resource.usage);
+				options.aliasedMemory = &slot.allocation;
+				resource.transient = std::make_unique<Texture>(device_ptr, options);
+				resource.texture = resource.transient.get();
+			}
+		}
+	}
+	void RenderGraph::beginTransient(uint32_t id)
+	{
+		//the previous occupant of the memory has to be done with it, its content is dropped
+		Resource& resource = resources[id];
+		ResourceState state{};
+		uint32_t occupant = slots[resource.slot].occupant;
+		if (occupant != UINT32_MAX) {
+			Texture& previous = *resources[occupant].texture;
+			for (uint32_t level = 0; level < previous.getMipLevels(); level++) {
+				const ResourceState& levelState = previous.getResourceState(level);
+				state.writeStageMask |= levelState.writeStageMask | levelState.readStageMask;
+				state.writeAccessMask |= levelState.writeAccessMask;
+			}
+		}
+
+		for (uint32_t level = 0; level < resource.texture->getMipLevels(); level++) {
+			resource.texture->getResourceState(level) = state;
+		}
+		slots[resource.slot].occupant = id;
+	}
+	void RenderGraph::destroyTransients()
+	{
+		for (auto& resource : resources) {
+			if (!resource.imported) {
+				resource.transient.reset();
+				resource.texture = nullptr;
+			}
+		}
+		for (auto& slot : slots) {
+			device_ptr->getMemoryAllocator().free(slot.allocation);
+		}
+		slots.clear();
+	}
+}
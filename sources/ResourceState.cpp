@@ -0,0 +1,139 @@
+#include <ResourceState.hpp>
+#include <stdexcept>
+
+namespace basicvk {
+	AccessInfo getAccessInfo(ResourceAccess access)
+	{
+		switch (access) {
+		case ResourceAccess::IndirectRead:
+			return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceAccess::IndexRead:
+			return { VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceAccess::VertexRead:
+			return { VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceAccess::UniformRead:
+			return { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				VK_ACCESS_2_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+		case ResourceAccess::FragmentSampledRead:
+			return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false };
+		case ResourceAccess::ComputeSampledRead:
+			return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false };
+		case ResourceAccess::ComputeStorageRead:
+			return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false };
+		case ResourceAccess::ComputeStorageWrite:
+			return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true };
+		case ResourceAccess::ComputeStorageReadWrite:
+			return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true };
+		case ResourceAccess::ColorAttachmentWrite:
+			return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true };
+		case ResourceAccess::DepthAttachmentWrite:
+			return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true };
+		case ResourceAccess::DepthAttachmentRead:
+			return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT
+				| VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false };
+		case ResourceAccess::TransferRead:
+			return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false };
+		case ResourceAccess::TransferWrite:
+			return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true };
+		case ResourceAccess::HostWrite:
+			return { VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, true };
+		case ResourceAccess::Present:
+			return { VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false };
+		default:
+			throw std::invalid_argument("unknown resource access");
+		}
+	}
+	static_assert(static_cast<uint32_t>(ResourceAccess::Present) < 32, "visibleReads holds a bit per resource access");
+
+	//a barrier makes every access of its destination mask visible to every stage of it, pairs of separate barriers don't combine
+	static bool isReadVisible(const ResourceState& state, const AccessInfo& info)
+	{
+		for (uint32_t bit = 0; bit < 32; bit++) {
+			if (!(state.visibleReads & (1u << bit))) {
+				continue;
+			}
+			AccessInfo visible = getAccessInfo(static_cast<ResourceAccess>(bit));
+			if ((info.stageMask & ~visible.stageMask) == 0 && (info.accessMask & ~visible.accessMask) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool transitionState(ResourceState& state, ResourceAccess access, bool isImage, StateTransition& transition)
+	{
+		AccessInfo info = getAccessInfo(access);
+		VkImageLayout newLayout = isImage ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		bool layoutChange = isImage && newLayout != state.layout;
+
+		transition.dstStageMask = info.stageMask;
+		transition.dstAccessMask = info.accessMask;
+		transition.oldLayout = state.layout;
+		transition.newLayout = newLayout;
+
+		if (!info.write && !layoutChange) {
+			//read after read needs nothing, read after write only once per stage and access
+			bool visible = state.writeStageMask == VK_PIPELINE_STAGE_2_NONE || isReadVisible(state, info);
+			state.readStageMask |= info.stageMask;
+			state.readAccessMask |= info.accessMask;
+			state.visibleReads |= 1u << static_cast<uint32_t>(access);
+			if (visible) {
+				return false;
+			}
+			transition.srcStageMask = state.writeStageMask;
+			transition.srcAccessMask = state.writeAccessMask;
+			return true;
+		}
+
+		//writes and layout transitions wait for the last write and every read since
+		transition.srcStageMask = state.writeStageMask | state.readStageMask;
+		transition.srcAccessMask = state.writeAccessMask;
+		bool needed = layoutChange || transition.srcStageMask != VK_PIPELINE_STAGE_2_NONE;
+
+		//a transition to a read layout is itself a write, later reads in other stages chain on its destination stage
+		state.layout = newLayout;
+		state.writeStageMask = info.stageMask;
+		state.writeAccessMask = info.write ? info.accessMask : VK_ACCESS_2_NONE;
+		state.readStageMask = info.write ? VK_PIPELINE_STAGE_2_NONE : info.stageMask;
+		state.readAccessMask = info.write ? VK_ACCESS_2_NONE : info.accessMask;
+		state.visibleReads = info.write ? 0 : 1u << static_cast<uint32_t>(access);
+		return needed;
+	}
+	ResourceState getUnknownState(VkImageLayout layout)
+	{
+		ResourceState state{};
+		state.layout = layout;
+		state.writeStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		state.writeAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+		return state;
+	}
+	VkImageAspectFlags getImageAspectMask(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+	VkImageAspectFlags getImageViewAspectMask(VkFormat format)
+	{
+		VkImageAspectFlags aspectMask = getImageAspectMask(format);
+		if (aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) {
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		}
+		return aspectMask;
+	}
+}
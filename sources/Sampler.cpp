@@ -0,0 +1,92 @@
+#include <Sampler.hpp>
+#include <algorithm>
+#include <functional>
+
+namespace basicvk {
+	bool SamplerDescription::operator==(const SamplerDescription& other) const
+	{
+		return magFilter == other.magFilter && minFilter == other.minFilter && mipmapMode == other.mipmapMode
+			&& addressModeU == other.addressModeU && addressModeV == other.addressModeV && addressModeW == other.addressModeW
+			&& mipLodBias == other.mipLodBias && anisotropyEnable == other.anisotropyEnable && maxAnisotropy == other.maxAnisotropy
+			&& compareEnable == other.compareEnable && compareOp == other.compareOp
+			&& minLod == other.minLod && maxLod == other.maxLod
+			&& borderColor == other.borderColor && unnormalizedCoordinates == other.unnormalizedCoordinates;
+	}
+
+	size_t SamplerDescriptionHash::operator()(const SamplerDescription& description) const
+	{
+		size_t seed = 0;
+		auto combine = [&seed](size_t value) {
+			seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		};
+		combine(std::hash<int>()(description.magFilter));
+		combine(std::hash<int>()(description.minFilter));
+		combine(std::hash<int>()(description.mipmapMode));
+		combine(std::hash<int>()(description.addressModeU));
+		combine(std::hash<int>()(description.addressModeV));
+		combine(std::hash<int>()(description.addressModeW));
+		combine(std::hash<float>()(description.mipLodBias));
+		combine(std::hash<bool>()(description.anisotropyEnable));
+		combine(std::hash<float>()(description.maxAnisotropy));
+		combine(std::hash<bool>()(description.compareEnable));
+		combine(std::hash<int>()(description.compareOp));
+		combine(std::hash<float>()(description.minLod));
+		combine(std::hash<float>()(description.maxLod));
+		combine(std::hash<int>()(description.borderColor));
+		combine(std::hash<bool>()(description.unnormalizedCoordinates));
+		return seed;
+	}
+
+	SamplerCache::SamplerCache(VkDevice device, std::shared_ptr<PhysicalDevice> physicalDevice)
+		: device(device), maxSamplerAnisotropy(1.0f), samplers(), mutex()
+	{
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice->getVkPhysicalDevice(), &properties);
+		maxSamplerAnisotropy = properties.limits.maxSamplerAnisotropy;
+	}
+	SamplerCache::~SamplerCache()
+	{
+		for (auto& entry : samplers) {
+			vkDestroySampler(device, entry.second, VK_NULL_HANDLE);
+		}
+		samplers.clear();
+	}
+	VkSampler SamplerCache::getSampler(const SamplerDescription& description)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = samplers.find(description);
+		if (it != samplers.end()) {
+			return it->second;
+		}
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = description.magFilter;
+		samplerInfo.minFilter = description.minFilter;
+		samplerInfo.addressModeU = description.addressModeU;
+		samplerInfo.addressModeV = description.addressModeV;
+		samplerInfo.addressModeW = description.addressModeW;
+		samplerInfo.anisotropyEnable = description.anisotropyEnable ? VK_TRUE : VK_FALSE;
+		samplerInfo.maxAnisotropy = description.maxAnisotropy > 0.0f ? std::min(description.maxAnisotropy, maxSamplerAnisotropy) : maxSamplerAnisotropy;
+		samplerInfo.borderColor = description.borderColor;
+		samplerInfo.unnormalizedCoordinates = description.unnormalizedCoordinates ? VK_TRUE : VK_FALSE;
+		samplerInfo.compareEnable = description.compareEnable ? VK_TRUE : VK_FALSE;
+		samplerInfo.compareOp = description.compareOp;
+		samplerInfo.mipmapMode = description.mipmapMode;
+		samplerInfo.mipLodBias = description.mipLodBias;
+		samplerInfo.minLod = description.minLod;
+		samplerInfo.maxLod = description.maxLod;
+
+		VkSampler sampler;
+		if (vkCreateSampler(device, &samplerInfo, VK_NULL_HANDLE, &sampler) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create texture sampler!");
+		}
+		samplers.emplace(description, sampler);
+		return sampler;
+	}
+	size_t SamplerCache::getSamplerCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return samplers.size();
+	}
+}
@@ -2,43 +2,50 @@
 #include <fstream>
 
 namespace basicvk {
-	Shader::Shader(std::shared_ptr<Device> device, const std::string& vertexPath, const std::string& fragmentPath)
-		: device_ptr(device), fragmentShaderModule(VK_NULL_HANDLE), vertexShaderModule(VK_NULL_HANDLE)
+	static std::vector<char> readFile(const std::string& path)
 	{
-		auto readFile = [](const std::string& path) -> std::vector<char> {
-			std::ifstream file(path, std::ios::ate | std::ios::binary);
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
 
-			if (!file.is_open()) {
-				throw std::runtime_error("failed to open file : " + path);
-			}
-			size_t fileSize = (size_t)file.tellg();
-			std::vector<char> buffer(fileSize);
-			file.seekg(0);
-			file.read(buffer.data(), fileSize);
-			file.close();
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open file : " + path);
+		}
+		size_t fileSize = (size_t)file.tellg();
+		std::vector<char> buffer(fileSize);
+		file.seekg(0);
+		file.read(buffer.data(), fileSize);
+		file.close();
 
-			return buffer;
-		};
+		return buffer;
+	}
 
-		auto createShaderModule = [device, readFile](const std::string& path) -> VkShaderModule {
-			std::vector<char> code = readFile(path);
+	static VkShaderModule createShaderModule(const Device& device, const std::string& path)
+	{
+		std::vector<char> code = readFile(path);
 
-			VkShaderModuleCreateInfo createInfo{};
-			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			createInfo.codeSize = code.size();
-			createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-			VkShaderModule shaderModule;
-			if (vkCreateShaderModule(device->getVkDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-				throw std::runtime_error("failed to create shader module!");
-			}
-			return shaderModule;
-		};
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(device.getVkDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shader module!");
+		}
+		return shaderModule;
+	}
 
-		this->vertexShaderModule = createShaderModule(vertexPath);
-		this->fragmentShaderModule = createShaderModule(fragmentPath);
+	Shader::Shader(std::shared_ptr<Device> device, const std::string& vertexPath, const std::string& fragmentPath)
+		: device_ptr(device), fragmentShaderModule(VK_NULL_HANDLE), vertexShaderModule(VK_NULL_HANDLE), computeShaderModule(VK_NULL_HANDLE)
+	{
+		this->vertexShaderModule = createShaderModule(*device, vertexPath);
+		this->fragmentShaderModule = createShaderModule(*device, fragmentPath);
 
 	}
+	Shader::Shader(std::shared_ptr<Device> device, const std::string& computePath)
+		: device_ptr(device), fragmentShaderModule(VK_NULL_HANDLE), vertexShaderModule(VK_NULL_HANDLE), computeShaderModule(VK_NULL_HANDLE)
+	{
+		this->computeShaderModule = createShaderModule(*device, computePath);
+	}
 	Shader::~Shader()
 	{
 		if (vertexShaderModule != VK_NULL_HANDLE) {
@@ -49,6 +56,10 @@ namespace basicvk {
 			vkDestroyShaderModule(device_ptr->getVkDevice(), fragmentShaderModule, VK_NULL_HANDLE);
 			fragmentShaderModule = VK_NULL_HANDLE;
 		}
+		if (computeShaderModule != VK_NULL_HANDLE) {
+			vkDestroyShaderModule(device_ptr->getVkDevice(), computeShaderModule, VK_NULL_HANDLE);
+			computeShaderModule = VK_NULL_HANDLE;
+		}
 	}
 	VkShaderModule Shader::getVkFragmentShaderModule() const
 	{
@@ -58,8 +69,20 @@ namespace basicvk {
 	{
 		return vertexShaderModule;
 	}
+	VkShaderModule Shader::getVkComputeShaderModule() const
+	{
+		return computeShaderModule;
+	}
+	bool Shader::isCompute() const
+	{
+		return computeShaderModule != VK_NULL_HANDLE;
+	}
 	std::array<VkPipelineShaderStageCreateInfo, 2> Shader::getPipelineShaderStageCreateInfo() const
 	{
+		if (isCompute()) {
+			throw std::invalid_argument("compute shader has no graphic stages");
+		}
+
 		VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
 		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -75,4 +98,17 @@ namespace basicvk {
 		std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
 		return shaderStages;
 	}
+	VkPipelineShaderStageCreateInfo Shader::getComputeShaderStageCreateInfo() const
+	{
+		if (!isCompute()) {
+			throw std::invalid_argument("shader has no compute stage");
+		}
+
+		VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
+		computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		computeShaderStageInfo.module = computeShaderModule;
+		computeShaderStageInfo.pName = "main";
+		return computeShaderStageInfo;
+	}
 }
\ No newline at end of file
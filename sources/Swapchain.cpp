@@ -157,6 +157,10 @@ namespace basicvk {
     {
         return swapChainImageViews;
     }
+    const std::vector<VkImage>& Swapchain::getVkSwapchainImages() const
+    {
+        return swapChainImages;
+    }
 
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
     {
@@ -1,4 +1,6 @@
 #include <Synchronous.hpp>
+#include <Command.hpp>
+#include <algorithm>
 
 namespace basicvk {
 	Fence::Fence(std::shared_ptr<Device> device, FenceOptions options)
@@ -54,6 +56,10 @@ namespace basicvk {
 			throw std::runtime_error("unable to reset fence");
 		}
 	}
+	bool Fence::isSignaled() const
+	{
+		return vkGetFenceStatus(device_ptr->getVkDevice(), fence) == VK_SUCCESS;
+	}
 
 
 	Semaphore::Semaphore(std::shared_ptr<Device> device)
@@ -95,4 +101,264 @@ namespace basicvk {
 	{
 		return semaphore;
 	}
+
+
+	TimelineSemaphore::TimelineSemaphore(std::shared_ptr<Device> device, uint64_t initialValue)
+		: semaphore(VK_NULL_HANDLE), device_ptr(device)
+	{
+		if (!device->getFeatures().timelineSemaphore) {
+			throw std::runtime_error("timeline semaphores are not supported by this device");
+		}
+
+		VkSemaphoreTypeCreateInfo typeCreateInfo{};
+		typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeCreateInfo.initialValue = initialValue;
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo{};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+		if (vkCreateSemaphore(device->getVkDevice(), &semaphoreCreateInfo, VK_NULL_HANDLE, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("unable to create timeline semaphore");
+		}
+	}
+	TimelineSemaphore::~TimelineSemaphore()
+	{
+		if (semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device_ptr->getVkDevice(), semaphore, VK_NULL_HANDLE);
+			semaphore = VK_NULL_HANDLE;
+		}
+	}
+	VkSemaphore TimelineSemaphore::getVkSemaphore() const
+	{
+		return semaphore;
+	}
+	uint64_t TimelineSemaphore::getValue() const
+	{
+		uint64_t value = 0;
+		if (vkGetSemaphoreCounterValue(device_ptr->getVkDevice(), semaphore, &value) != VK_SUCCESS) {
+			throw std::runtime_error("unable to read timeline semaphore value");
+		}
+		return value;
+	}
+	bool TimelineSemaphore::wait(uint64_t value, uint64_t timeout) const
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &semaphore;
+		waitInfo.pValues = &value;
+
+		VkResult result = vkWaitSemaphores(device_ptr->getVkDevice(), &waitInfo, timeout);
+		if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+			throw std::runtime_error("wait for timeline semaphore failed");
+		}
+		return result == VK_SUCCESS;
+	}
+	void TimelineSemaphore::signal(uint64_t value) const
+	{
+		VkSemaphoreSignalInfo signalInfo{};
+		signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+		signalInfo.semaphore = semaphore;
+		signalInfo.value = value;
+
+		if (vkSignalSemaphore(device_ptr->getVkDevice(), &signalInfo) != VK_SUCCESS) {
+			throw std::runtime_error("unable to signal timeline semaphore");
+		}
+	}
+
+
+	QueueTimeline::QueueTimeline(std::shared_ptr<Device> device, Queue queue)
+		: device_ptr(device), queue(queue), semaphore(), submitMutex(), lastSubmitted(0), completed(0), pendingFences(), freeFences(), fenceWaiters(0)
+	{
+		if (device->getFeatures().timelineSemaphore) {
+			semaphore = std::make_unique<TimelineSemaphore>(device, 0);
+		}
+	}
+	QueueTimeline::~QueueTimeline()
+	{
+		waitIdle();
+		for (VkFence fence : freeFences) {
+			vkDestroyFence(device_ptr->getVkDevice(), fence, VK_NULL_HANDLE);
+		}
+	}
+	uint64_t QueueTimeline::submit(const CommandBuffer& commandBuffer, const std::vector<SemaphoreWait>& waitSemaphores,
+		const std::vector<const Semaphore*>& signalSemaphores, const std::vector<TimelineWait>& waitTimelines)
+	{
+		//binary semaphores ignore their value, they still need a slot in the value arrays
+		std::vector<VkSemaphore> waitVkSemaphores;
+		std::vector<VkPipelineStageFlags> waitStages;
+		std::vector<uint64_t> waitValues;
+		for (const auto& wait : waitSemaphores) {
+			waitVkSemaphores.push_back(wait.semaphore->getVkSemaphore());
+			waitStages.push_back(wait.stageMask);
+			waitValues.push_back(0);
+		}
+		for (const auto& wait : waitTimelines) {
+			if (wait.ticket == 0) {
+				continue;
+			}
+			if (!wait.timeline->semaphore) {
+				//no semaphore the gpu could wait on, the work it depends on is finished before this one is submitted
+				wait.timeline->wait(wait.ticket);
+				continue;
+			}
+			waitVkSemaphores.push_back(wait.timeline->getSemaphore().getVkSemaphore());
+			waitStages.push_back(wait.stageMask);
+			waitValues.push_back(wait.ticket);
+		}
+
+		std::vector<VkSemaphore> signalVkSemaphores;
+		std::vector<uint64_t> signalValues;
+		for (const Semaphore* signal : signalSemaphores) {
+			signalVkSemaphores.push_back(signal->getVkSemaphore());
+			signalValues.push_back(0);
+		}
+		if (semaphore) {
+			signalVkSemaphores.push_back(semaphore->getVkSemaphore());
+			signalValues.push_back(0);
+		}
+
+		VkCommandBuffer vkCommandBuffer = commandBuffer.getVkCommandBuffer();
+
+		//values must reach the queue in increasing order, the ticket is taken and submitted under the same lock
+		std::lock_guard<std::mutex> lock(submitMutex);
+		uint64_t ticket = lastSubmitted + 1;
+		if (semaphore) {
+			signalValues.back() = ticket;
+		}
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+		timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = semaphore ? &timelineInfo : nullptr;
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitVkSemaphores.size());
+		submitInfo.pWaitSemaphores = waitVkSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &vkCommandBuffer;
+		submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalVkSemaphores.size());
+		submitInfo.pSignalSemaphores = signalVkSemaphores.data();
+
+		VkFence fence = semaphore ? VK_NULL_HANDLE : acquireFence();
+		if (vkQueueSubmit(queue.getVkQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+			if (fence != VK_NULL_HANDLE) {
+				freeFences.push_back(fence);
+			}
+			throw std::runtime_error("unable to submit command buffer!");
+		}
+		if (fence != VK_NULL_HANDLE) {
+			pendingFences.push_back({ ticket, fence });
+		}
+		lastSubmitted = ticket;
+		return ticket;
+	}
+	bool QueueTimeline::isComplete(uint64_t ticket) const
+	{
+		return ticket == 0 || getCompleted() >= ticket;
+	}
+	void QueueTimeline::wait(uint64_t ticket) const
+	{
+		if (ticket == 0) {
+			return;
+		}
+		if (semaphore) {
+			semaphore->wait(ticket, UINT64_MAX);
+			return;
+		}
+
+		//the fence is waited on without the lock so other threads keep submitting, it can't be reset meanwhile
+		std::unique_lock<std::mutex> lock(submitMutex);
+		retireFences();
+		while (completed < ticket) {
+			auto pending = std::find_if(pendingFences.begin(), pendingFences.end(), [ticket](const PendingFence& entry) { return entry.ticket >= ticket; });
+			if (pending == pendingFences.end()) {
+				return;
+			}
+			VkFence fence = pending->fence;
+			fenceWaiters++;
+			lock.unlock();
+			VkResult result = vkWaitForFences(device_ptr->getVkDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+			lock.lock();
+			fenceWaiters--;
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error("wait for submission fence failed");
+			}
+			retireFences();
+		}
+	}
+	void QueueTimeline::waitIdle() const
+	{
+		wait(getLastSubmitted());
+	}
+	uint64_t QueueTimeline::getLastSubmitted() const
+	{
+		std::lock_guard<std::mutex> lock(submitMutex);
+		return lastSubmitted;
+	}
+	uint64_t QueueTimeline::getCompleted() const
+	{
+		if (semaphore) {
+			return semaphore->getValue();
+		}
+		std::lock_guard<std::mutex> lock(submitMutex);
+		retireFences();
+		return completed;
+	}
+	bool QueueTimeline::usesFences() const
+	{
+		return !semaphore;
+	}
+	const TimelineSemaphore& QueueTimeline::getSemaphore() const
+	{
+		if (!semaphore) {
+			throw std::runtime_error("queue timeline uses fences, timeline semaphores are not supported by this device");
+		}
+		return *semaphore;
+	}
+	Queue QueueTimeline::getQueue() const
+	{
+		return queue;
+	}
+	VkFence QueueTimeline::acquireFence()
+	{
+		if (!freeFences.empty() && fenceWaiters == 0) {
+			VkFence fence = freeFences.back();
+			freeFences.pop_back();
+			vkResetFences(device_ptr->getVkDevice(), 1, &fence);
+			return fence;
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence;
+		if (vkCreateFence(device_ptr->getVkDevice(), &fenceInfo, VK_NULL_HANDLE, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create fence!");
+		}
+		return fence;
+	}
+	void QueueTimeline::retireFences() const
+	{
+		//a fence signals once every earlier submission to the queue completed, so tickets complete in order
+		while (!pendingFences.empty()) {
+			const PendingFence& pending = pendingFences.front();
+			VkResult status = vkGetFenceStatus(device_ptr->getVkDevice(), pending.fence);
+			if (status == VK_NOT_READY) {
+				break;
+			}
+			if (status != VK_SUCCESS) {
+				throw std::runtime_error("wait for submission fence failed");
+			}
+			freeFences.push_back(pending.fence);
+			completed = pending.ticket;
+			pendingFences.pop_front();
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include <TextureFile.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace basicvk {
+	static const unsigned char ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	static const uint32_t ddsMagic = 0x20534444;	//"DDS "
+
+	static constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+	{
+		return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+	}
+
+	template<typename T>
+	static T readValue(const std::vector<char>& data, uint64_t offset)
+	{
+		if (offset + sizeof(T) > data.size()) {
+			throw std::runtime_error("texture file is truncated");
+		}
+		T value;
+		memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+
+	//a full chain down to 1x1, every level past it would shift the extent by 32 bits or more
+	static uint32_t getMaxLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levelCount = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+			levelCount++;
+		}
+		return levelCount;
+	}
+
+	static VkFormat dxgiToVkFormat(uint32_t dxgiFormat)
+	{
+		switch (dxgiFormat) {
+		case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+		case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+		case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+		case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+		case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+		case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+		case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+		case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+		case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+		case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+		case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+		case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	TextureFile::TextureFile(const std::string& path)
+		: data(), format(VK_FORMAT_UNDEFINED), width(0), height(0), levels()
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error("failed to open texture file!");
+		}
+
+		size_t fileSize = (size_t)file.tellg();
+		data.resize(fileSize);
+		file.seekg(0);
+		file.read(data.data(), fileSize);
+		file.close();
+
+		if (data.size() >= sizeof(ktx2Identifier) && memcmp(data.data(), ktx2Identifier, sizeof(ktx2Identifier)) == 0) {
+			parseKTX2();
+		}
+		else if (data.size() >= 4 && readValue<uint32_t>(data, 0) == ddsMagic) {
+			parseDDS();
+		}
+		else {
+			throw std::runtime_error("unknown texture container");
+		}
+	}
+	bool TextureFile::isTextureFile(const std::string& path)
+	{
+		size_t dot = path.find_last_of('.');
+		if (dot == std::string::npos) {
+			return false;
+		}
+		std::string extension = path.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+		return extension == "ktx2" || extension == "dds";
+	}
+	FormatBlockInfo TextureFile::getFormatBlockInfo(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			return { 4, 4, 8 };
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return { 4, 4, 16 };
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			return { 1, 1, 4 };
+		default:
+			throw std::runtime_error("unsupported texture file format");
+		}
+	}
+	VkFormat TextureFile::getFormat() const
+	{
+		return format;
+	}
+	uint32_t TextureFile::getWidth() const
+	{
+		return width;
+	}
+	uint32_t TextureFile::getHeight() const
+	{
+		return height;
+	}
+	const std::vector<TextureFileLevel>& TextureFile::getLevels() const
+	{
+		return levels;
+	}
+	const char* TextureFile::getData() const
+	{
+		return data.data();
+	}
+	void TextureFile::parseKTX2()
+	{
+		format = static_cast<VkFormat>(readValue<uint32_t>(data, 12));
+		width = readValue<uint32_t>(data, 20);
+		height = readValue<uint32_t>(data, 24);
+		uint32_t depth = readValue<uint32_t>(data, 28);
+		uint32_t layerCount = readValue<uint32_t>(data, 32);
+		uint32_t faceCount = readValue<uint32_t>(data, 36);
+		uint32_t levelCount = std::max(1u, readValue<uint32_t>(data, 40));
+		uint32_t supercompressionScheme = readValue<uint32_t>(data, 44);
+
+		if (supercompressionScheme != 0) {
+			throw std::runtime_error("supercompressed ktx2 files are not supported");
+		}
+		if (depth > 1 || layerCount > 1 || faceCount != 1 || width == 0 || height == 0) {
+			throw std::runtime_error("only 2d ktx2 textures are supported");
+		}
+		if (levelCount > getMaxLevelCount(width, height)) {
+			throw std::runtime_error("ktx2 file has more levels than its extent allows");
+		}
+		FormatBlockInfo blockInfo = getFormatBlockInfo(format);
+
+		//the level index follows the 80 bytes header, level 0 first
+		for (uint32_t i = 0; i < levelCount; i++) {
+			uint64_t entry = 80 + static_cast<uint64_t>(i) * 24;
+			TextureFileLevel level{};
+			level.offset = readValue<uint64_t>(data, entry);
+			level.size = readValue<uint64_t>(data, entry + 8);
+			level.width = std::max(1u, width >> i);
+			level.height = std::max(1u, height >> i);
+
+			uint64_t expectedSize = static_cast<uint64_t>((level.width + blockInfo.blockWidth - 1) / blockInfo.blockWidth)
+				* ((level.height + blockInfo.blockHeight - 1) / blockInfo.blockHeight) * blockInfo.bytesPerBlock;
+			if (level.size != expectedSize || level.offset > data.size() || level.size > data.size() - level.offset) {
+				throw std::runtime_error("ktx2 level does not match its format");
+			}
+			levels.push_back(level);
+		}
+	}
+	void TextureFile::parseDDS()
+	{
+		const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+		uint32_t headerFlags = readValue<uint32_t>(data, 8);
+		height = readValue<uint32_t>(data, 12);
+		width = readValue<uint32_t>(data, 16);
+		//the count is only meaningful with its flag, writers leave garbage in it otherwise
+		uint32_t levelCount = (headerFlags & DDSD_MIPMAPCOUNT) ? std::max(1u, readValue<uint32_t>(data, 28)) : 1;
+		if (width == 0 || height == 0) {
+			throw std::runtime_error("dds texture has an empty extent");
+		}
+		if (levelCount > getMaxLevelCount(width, height)) {
+			throw std::runtime_error("dds file has more levels than its extent allows");
+		}
+		uint32_t pixelFormatFlags = readValue<uint32_t>(data, 80);
+		uint32_t fourCC = readValue<uint32_t>(data, 84);
+		uint64_t dataOffset = 128;
+
+		const uint32_t DDPF_FOURCC = 0x4;
+		const uint32_t DDPF_RGB = 0x40;
+		if (pixelFormatFlags & DDPF_FOURCC) {
+			switch (fourCC) {
+			case makeFourCC('D', 'X', 'T', '1'): format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK; break;
+			case makeFourCC('D', 'X', 'T', '3'): format = VK_FORMAT_BC2_UNORM_BLOCK; break;
+			case makeFourCC('D', 'X', 'T', '5'): format = VK_FORMAT_BC3_UNORM_BLOCK; break;
+			case makeFourCC('A', 'T', 'I', '1'):
+			case makeFourCC('B', 'C', '4', 'U'): format = VK_FORMAT_BC4_UNORM_BLOCK; break;
+			case makeFourCC('A', 'T', 'I', '2'):
+			case makeFourCC('B', 'C', '5', 'U'): format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+			case makeFourCC('D', 'X', '1', '0'): {
+				uint32_t resourceDimension = readValue<uint32_t>(data, 132);
+				uint32_t arraySize = readValue<uint32_t>(data, 140);
+				if (resourceDimension != 3 || arraySize > 1) {
+					throw std::runtime_error("only 2d dds textures are supported");
+				}
+				format = dxgiToVkFormat(readValue<uint32_t>(data, 128));
+				dataOffset += 20;
+				break;
+			}
+			default: break;
+			}
+		}
+		else if ((pixelFormatFlags & DDPF_RGB) && readValue<uint32_t>(data, 88) == 32) {
+			uint32_t redMask = readValue<uint32_t>(data, 92);
+			format = redMask == 0x000000ff ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+		}
+
+		if (format == VK_FORMAT_UNDEFINED) {
+			throw std::runtime_error("unsupported dds pixel format");
+		}
+		computeLevels(dataOffset, levelCount);
+	}
+	void TextureFile::computeLevels(uint64_t dataOffset, uint32_t levelCount)
+	{
+		//dds stores the levels back to back, level 0 first
+		FormatBlockInfo blockInfo = getFormatBlockInfo(format);
+		uint64_t offset = dataOffset;
+		for (uint32_t i = 0; i < levelCount; i++) {
+			TextureFileLevel level{};
+			level.offset = offset;
+			level.width = std::max(1u, width >> i);
+			level.height = std::max(1u, height >> i);
+			level.size = static_cast<uint64_t>((level.width + blockInfo.blockWidth - 1) / blockInfo.blockWidth)
+				* ((level.height + blockInfo.blockHeight - 1) / blockInfo.blockHeight) * blockInfo.bytesPerBlock;
+			if (level.offset + level.size > data.size()) {
+				throw std::runtime_error("texture file is truncated");
+			}
+			levels.push_back(level);
+			offset += level.size;
+		}
+	}
+}
@@ -0,0 +1,376 @@
+#include <TextureLoader.hpp>
+#include <TextureFile.hpp>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../third_party/stb_image.h"
+
+namespace basicvk {
+	TextureLoadState StreamedTexture::getState() const
+	{
+		return state.load();
+	}
+	bool StreamedTexture::isReady() const
+	{
+		return state.load() == TextureLoadState::Ready;
+	}
+	bool StreamedTexture::hasFailed() const
+	{
+		return state.load() == TextureLoadState::Failed;
+	}
+	const std::string& StreamedTexture::getPath() const
+	{
+		return path;
+	}
+	const std::string& StreamedTexture::getError() const
+	{
+		return error;
+	}
+	Texture& StreamedTexture::getTexture() const
+	{
+		if (!isReady()) {
+			throw std::runtime_error("texture is not resident yet");
+		}
+		return *texture;
+	}
+	uint32_t StreamedTexture::getBindlessIndex() const
+	{
+		return bindlessIndex;
+	}
+
+	TextureLoader::TextureLoader(std::shared_ptr<Device> device, std::shared_ptr<QueueTimeline> timeline, TextureLoaderOptions options)
+		: device_ptr(device), options(options), timeline(timeline), commandPool(device, timeline->getQueue()), batches(), decodedMutex(), decoded(), decodingCount(0)
+		, threadPool(options.workerCount != 0 ? options.workerCount : std::max(2u, std::thread::hardware_concurrency()) - 1)
+	{
+	}
+	TextureLoader::~TextureLoader()
+	{
+		for (auto& batch : batches) {
+			if (batch->inFlight) {
+				timeline->wait(batch->ticket);
+			}
+		}
+	}
+	TextureHandle TextureLoader::load(const std::string& path)
+	{
+		TextureHandle handle = std::make_shared<StreamedTexture>();
+		handle->path = path;
+		if (options.bindless != nullptr) {
+			handle->bindlessIndex = options.bindless->reserveTexture();
+		}
+
+		decodingCount++;
+		threadPool.enqueue([this, handle]() { decode(handle); });
+		return handle;
+	}
+	TextureHandle TextureLoader::load(std::shared_ptr<AssetPack> pack, const std::string& name)
+	{
+		TextureHandle handle = std::make_shared<StreamedTexture>();
+		handle->path = name;
+		handle->pack = pack;
+		if (options.bindless != nullptr) {
+			handle->bindlessIndex = options.bindless->reserveTexture();
+		}
+
+		decodingCount++;
+		threadPool.enqueue([this, handle]() { decode(handle); });
+		return handle;
+	}
+	uint32_t TextureLoader::update()
+	{
+		retireBatches();
+
+		std::vector<TextureHandle> toUpload;
+		{
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			toUpload.swap(decoded);
+		}
+
+		for (size_t first = 0; first < toUpload.size(); first += options.maxTexturesPerBatch) {
+			size_t last = std::min(toUpload.size(), first + options.maxTexturesPerBatch);
+			UploadBatch& batch = acquireBatch();
+
+			batch.commandBuffer->resetCommandBuffer();
+			batch.commandBuffer->beginCommandBuffer({ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT });
+			//grouped so that every texture of the batch shares one barrier before the copies and one after
+			for (size_t i = first; i < last; i++) {
+				batch.commandBuffer->requireAccess(*toUpload[i]->texture, ResourceAccess::TransferWrite);
+			}
+			for (size_t i = first; i < last; i++) {
+				Texture& texture = *toUpload[i]->texture;
+				if (!toUpload[i]->copyRegions.empty()) {
+					batch.commandBuffer->CopyBufferToTexture(*toUpload[i]->stagingBuffer, texture, toUpload[i]->copyRegions);
+				}
+				else {
+					batch.commandBuffer->CopyBufferToTexture(*toUpload[i]->stagingBuffer, texture);
+				}
+			}
+			for (size_t i = first; i < last; i++) {
+				Texture& texture = *toUpload[i]->texture;
+				if (toUpload[i]->copyRegions.empty() && texture.getMipLevels() > 1) {
+					batch.commandBuffer->generateMipMap(texture);
+				}
+				else {
+					batch.commandBuffer->requireAccess(texture, ResourceAccess::FragmentSampledRead);
+				}
+				toUpload[i]->state = TextureLoadState::Uploading;
+				batch.textures.push_back(toUpload[i]);
+			}
+			batch.commandBuffer->endCommandBuffer();
+
+			device_ptr->getMemoryAllocator().flushMappedRanges();
+			batch.ticket = timeline->submit(*batch.commandBuffer);
+			batch.inFlight = true;
+		}
+
+		return static_cast<uint32_t>(toUpload.size());
+	}
+	void TextureLoader::waitIdle()
+	{
+		while (getPendingCount() > 0) {
+			update();
+			for (auto& batch : batches) {
+				if (batch->inFlight) {
+					timeline->wait(batch->ticket);
+				}
+			}
+			retireBatches();
+			if (decodingCount.load() > 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+	uint32_t TextureLoader::getPendingCount()
+	{
+		uint32_t pending = decodingCount.load();
+		{
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			pending += static_cast<uint32_t>(decoded.size());
+		}
+		for (auto& batch : batches) {
+			pending += static_cast<uint32_t>(batch->textures.size());
+		}
+		return pending;
+	}
+	void TextureLoader::decode(TextureHandle handle)
+	{
+		//runs on a worker thread, the allocator is the only shared state it touches and it is locked
+		try {
+			if (handle->pack) {
+				decodePackedTexture(*handle);
+			}
+			else if (TextureFile::isTextureFile(handle->path)) {
+				decodeTextureFile(*handle);
+			}
+			else {
+				decodeImage(*handle);
+			}
+
+			handle->state = TextureLoadState::Decoded;
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			decoded.push_back(handle);
+		}
+		catch (const std::exception& e) {
+			handle->stagingBuffer.reset();
+			handle->texture.reset();
+			handle->copyRegions.clear();
+			handle->error = e.what();
+			//never written, so never used by the gpu
+			if (handle->bindlessIndex != UINT32_MAX) {
+				options.bindless->removeTexture(handle->bindlessIndex, 0);
+				handle->bindlessIndex = UINT32_MAX;
+			}
+			handle->state = TextureLoadState::Failed;
+		}
+		decodingCount--;
+	}
+	void TextureLoader::decodeImage(StreamedTexture& streamedTexture)
+	{
+		//decoders read back their own output, so they work on the heap and only the result goes to the write combined mapping
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load(streamedTexture.path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		if (pixels == nullptr) {
+			throw std::runtime_error("failed to load texture image!");
+		}
+		uint64_t imageSize = static_cast<uint64_t>(texWidth) * texHeight * 4;
+
+		BufferOptions stagingOptions{};
+		stagingOptions.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		stagingOptions.memoryUsage = MemoryUsage::Upload;
+		try {
+			streamedTexture.stagingBuffer = std::make_unique<Buffer>(device_ptr, stagingOptions, imageSize);
+		}
+		catch (...) {
+			stbi_image_free(pixels);
+			throw;
+		}
+		std::memcpy(streamedTexture.stagingBuffer->getMappedData(), pixels, static_cast<size_t>(imageSize));
+		stbi_image_free(pixels);
+		streamedTexture.stagingBuffer->flush();
+
+		TextureOptions textureOptions{};
+		textureOptions.width = static_cast<uint32_t>(texWidth);
+		textureOptions.height = static_cast<uint32_t>(texHeight);
+		textureOptions.format = options.format;
+		textureOptions.tiling = VK_IMAGE_TILING_OPTIMAL;
+		textureOptions.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		textureOptions.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		textureOptions.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		textureOptions.useMimaping = options.useMimaping;
+		streamedTexture.texture = std::make_unique<Texture>(device_ptr, textureOptions);
+	}
+	void TextureLoader::decodeTextureFile(StreamedTexture& streamedTexture)
+	{
+		TextureFile file(streamedTexture.path);
+		checkFormatSupport(file.getFormat());
+
+		//levels are repacked so every copy region starts on a texel block boundary
+		const std::vector<TextureFileLevel>& levels = file.getLevels();
+		std::vector<uint64_t> stagingOffsets(levels.size());
+		uint64_t stagingSize = 0;
+		for (size_t i = 0; i < levels.size(); i++) {
+			stagingOffsets[i] = (stagingSize + 15) & ~15ull;
+			stagingSize = stagingOffsets[i] + levels[i].size;
+		}
+
+		BufferOptions stagingOptions{};
+		stagingOptions.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		stagingOptions.memoryUsage = MemoryUsage::Upload;
+		streamedTexture.stagingBuffer = std::make_unique<Buffer>(device_ptr, stagingOptions, stagingSize);
+
+		for (size_t i = 0; i < levels.size(); i++) {
+			streamedTexture.stagingBuffer->write(file.getData() + levels[i].offset, levels[i].size, stagingOffsets[i]);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = stagingOffsets[i];
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = static_cast<uint32_t>(i);
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { levels[i].width, levels[i].height, 1 };
+			streamedTexture.copyRegions.push_back(region);
+		}
+
+		TextureOptions textureOptions{};
+		textureOptions.width = file.getWidth();
+		textureOptions.height = file.getHeight();
+		textureOptions.format = file.getFormat();
+		textureOptions.tiling = VK_IMAGE_TILING_OPTIMAL;
+		textureOptions.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		textureOptions.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		textureOptions.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		textureOptions.useMimaping = false;
+		textureOptions.mipLevels = static_cast<uint32_t>(levels.size());
+		streamedTexture.texture = std::make_unique<Texture>(device_ptr, textureOptions);
+	}
+	void TextureLoader::decodePackedTexture(StreamedTexture& streamedTexture)
+	{
+		const AssetPackEntry& entry = streamedTexture.pack->getEntry(streamedTexture.path);
+		if (entry.type != AssetType::Texture || entry.mipLevels == 0 || entry.mipLevels > ASSET_PACK_MAX_LEVELS
+			|| entry.width == 0 || entry.height == 0) {
+			throw std::runtime_error("asset is not a texture: " + streamedTexture.path);
+		}
+
+		checkFormatSupport(entry.format);
+		FormatBlockInfo blockInfo = TextureFile::getFormatBlockInfo(entry.format);
+
+		//the cooker already laid the levels out contiguously and aligned, they go to staging in one copy.
+		//a corrupt entry must fail here, before its offsets size the staging buffer
+		for (uint32_t i = 0; i < entry.mipLevels; i++) {
+			streamedTexture.pack->getData(entry.levels[i]);
+			uint32_t levelWidth = std::max(1u, entry.width >> i);
+			uint32_t levelHeight = std::max(1u, entry.height >> i);
+			uint64_t expectedSize = static_cast<uint64_t>((levelWidth + blockInfo.blockWidth - 1) / blockInfo.blockWidth)
+				* ((levelHeight + blockInfo.blockHeight - 1) / blockInfo.blockHeight) * blockInfo.bytesPerBlock;
+			if (entry.levels[i].size != expectedSize) {
+				throw std::runtime_error("texture level does not match its format: " + streamedTexture.path);
+			}
+			if (i > 0 && entry.levels[i].offset < entry.levels[i - 1].offset + entry.levels[i - 1].size) {
+				throw std::runtime_error("texture levels are out of order: " + streamedTexture.path);
+			}
+		}
+		const AssetPackRegion& first = entry.levels[0];
+		const AssetPackRegion& last = entry.levels[entry.mipLevels - 1];
+		AssetPackRegion levelsRegion{ first.offset, last.offset + last.size - first.offset };
+
+		BufferOptions stagingOptions{};
+		stagingOptions.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		stagingOptions.memoryUsage = MemoryUsage::Upload;
+		streamedTexture.stagingBuffer = std::make_unique<Buffer>(device_ptr, stagingOptions, levelsRegion.size);
+		streamedTexture.stagingBuffer->write(streamedTexture.pack->getData(levelsRegion), levelsRegion.size);
+
+		for (uint32_t i = 0; i < entry.mipLevels; i++) {
+			VkBufferImageCopy region{};
+			region.bufferOffset = entry.levels[i].offset - first.offset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = i;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { std::max(1u, entry.width >> i), std::max(1u, entry.height >> i), 1 };
+			streamedTexture.copyRegions.push_back(region);
+		}
+
+		TextureOptions textureOptions{};
+		textureOptions.width = entry.width;
+		textureOptions.height = entry.height;
+		textureOptions.format = entry.format;
+		textureOptions.tiling = VK_IMAGE_TILING_OPTIMAL;
+		textureOptions.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		textureOptions.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		textureOptions.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		textureOptions.useMimaping = false;
+		textureOptions.mipLevels = entry.mipLevels;
+		streamedTexture.texture = std::make_unique<Texture>(device_ptr, textureOptions);
+	}
+	void TextureLoader::checkFormatSupport(VkFormat format) const
+	{
+		VkFormatProperties formatProperties{};
+		vkGetPhysicalDeviceFormatProperties(device_ptr->getPhysicalDevice()->getVkPhysicalDevice(), format, &formatProperties);
+		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+			throw std::runtime_error("texture format is not supported by the device");
+		}
+	}
+	void TextureLoader::retireBatches()
+	{
+		for (auto& batch : batches) {
+			if (!batch->inFlight || !timeline->isComplete(batch->ticket)) {
+				continue;
+			}
+			for (auto& texture : batch->textures) {
+				texture->stagingBuffer.reset();
+				if (texture->bindlessIndex != UINT32_MAX) {
+					options.bindless->writeTexture(texture->bindlessIndex, *texture->texture);
+				}
+				texture->state = TextureLoadState::Ready;
+			}
+			batch->textures.clear();
+			batch->inFlight = false;
+		}
+	}
+	TextureLoader::UploadBatch& TextureLoader::acquireBatch()
+	{
+		for (auto& batch : batches) {
+			if (!batch->inFlight) {
+				return *batch;
+			}
+		}
+
+		std::unique_ptr<UploadBatch> batch = std::make_unique<UploadBatch>();
+		batch->commandBuffer = commandPool.allocateCommandBuffer();
+		batch->ticket = 0;
+		batch->inFlight = false;
+		batches.push_back(std::move(batch));
+		return *batches.back();
+	}
+}
@@ -0,0 +1,54 @@
+#include <ThreadPool.hpp>
+#include <stdexcept>
+
+namespace basicvk {
+	ThreadPool::ThreadPool(uint32_t threadCount)
+		: workers(), jobs(), mutex(), condition(), stopping(false)
+	{
+		if (threadCount == 0) {
+			throw std::runtime_error("thread pool needs at least one worker");
+		}
+		for (uint32_t i = 0; i < threadCount; i++) {
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+	uint32_t ThreadPool::getThreadCount() const
+	{
+		return static_cast<uint32_t>(workers.size());
+	}
+	void ThreadPool::push(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push(std::move(job));
+		}
+		condition.notify_one();
+	}
+	void ThreadPool::workerLoop()
+	{
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (stopping) {
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop();
+			}
+			job();
+		}
+	}
+}
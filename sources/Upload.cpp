@@ -0,0 +1,146 @@
+#include <Upload.hpp>
+#include <algorithm>
+
+namespace basicvk {
+	UploadManager::UploadManager(std::shared_ptr<Device> device, std::shared_ptr<QueueTimeline> timeline, UploadManagerOptions options)
+		: device_ptr(device), timeline(timeline), queue(timeline->getQueue()), commandPool(device, queue), slots(options.stagingBufferCount), releasedRanges()
+		, dstQueueFamilyIndex(options.dstQueueFamilyIndex == queue.getQueueFamilyIndex() ? VK_QUEUE_FAMILY_IGNORED : options.dstQueueFamilyIndex)
+		, stagingBufferSize(options.stagingBufferSize), currentSlot(0), lastTicket(0)
+	{
+		BufferOptions stagingOptions{};
+		stagingOptions.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		stagingOptions.memoryUsage = MemoryUsage::Upload;
+
+		for (auto& slot : slots) {
+			slot.stagingBuffer = std::make_unique<Buffer>(device, stagingOptions, stagingBufferSize);
+			slot.commandBuffer = commandPool.allocateCommandBuffer();
+			slot.used = 0;
+			slot.ticket = 0;
+			slot.recording = false;
+		}
+	}
+	UploadManager::~UploadManager()
+	{
+		for (auto& slot : slots) {
+			timeline->wait(slot.ticket);
+		}
+	}
+	void UploadManager::uploadBuffer(const Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset)
+	{
+		const char* src = static_cast<const char*>(data);
+		while (size > 0) {
+			StagingSlot& slot = beginSlot();
+			uint64_t offset = (slot.used + 15) & ~15ull;
+			if (offset >= stagingBufferSize) {
+				submit();
+				continue;
+			}
+
+			//bigger uploads than the staging buffer are split over several submissions
+			uint64_t chunkSize = std::min(size, stagingBufferSize - offset);
+			slot.stagingBuffer->write(src, chunkSize, offset);
+
+			auto pending = std::find_if(slot.pendingCopies.begin(), slot.pendingCopies.end(), [&dst](const PendingCopy& copy) {
+				return copy.dst == &dst;
+			});
+			if (pending == slot.pendingCopies.end()) {
+				slot.pendingCopies.push_back({ &dst, {} });
+				pending = slot.pendingCopies.end() - 1;
+			}
+			pending->regions.push_back({ offset, dstOffset, chunkSize });
+
+			slot.used = offset + chunkSize;
+			src += chunkSize;
+			dstOffset += chunkSize;
+			size -= chunkSize;
+		}
+	}
+	uint64_t UploadManager::submit()
+	{
+		StagingSlot& slot = slots[currentSlot];
+		if (!slot.recording) {
+			return lastTicket;
+		}
+
+		for (const auto& copy : slot.pendingCopies) {
+			slot.commandBuffer->CopyBuffer(*slot.stagingBuffer, *copy.dst, copy.regions);
+		}
+
+		size_t firstReleased = releasedRanges.size();
+		if (dstQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) {
+			//makes the copies visible to whatever reads the buffers in later submissions
+			slot.commandBuffer->memoryBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT);
+		}
+		else {
+			//release half of the ownership transfer, one range per buffer covering all of its regions
+			std::vector<BufferBarrier> releases;
+			for (const auto& copy : slot.pendingCopies) {
+				VkDeviceSize begin = copy.regions.front().dstOffset;
+				VkDeviceSize end = begin;
+				for (const auto& region : copy.regions) {
+					begin = std::min(begin, region.dstOffset);
+					end = std::max(end, region.dstOffset + region.size);
+				}
+				releases.push_back({ copy.dst, VK_ACCESS_TRANSFER_WRITE_BIT, 0, begin, end - begin,
+					queue.getQueueFamilyIndex(), dstQueueFamilyIndex });
+				releasedRanges.push_back({ copy.dst, begin, end - begin, 0 });
+			}
+			slot.commandBuffer->bufferBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, releases);
+		}
+
+		slot.commandBuffer->endCommandBuffer();
+		device_ptr->getMemoryAllocator().flushMappedRanges();
+		uint64_t ticket = timeline->submit(*slot.commandBuffer);
+		for (size_t i = firstReleased; i < releasedRanges.size(); i++) {
+			releasedRanges[i].ticket = ticket;
+		}
+		slot.pendingCopies.clear();
+
+		slot.ticket = ticket;
+		lastTicket = ticket;
+		slot.recording = false;
+		currentSlot = (currentSlot + 1) % static_cast<uint32_t>(slots.size());
+		return slot.ticket;
+	}
+	bool UploadManager::isComplete(uint64_t ticket) const
+	{
+		return timeline->isComplete(ticket);
+	}
+	void UploadManager::wait(uint64_t ticket) const
+	{
+		timeline->wait(ticket);
+	}
+	void UploadManager::acquireOwnership(const CommandBuffer& commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccessMask)
+	{
+		//the release has executed once its ticket completed, pending ones wait for a later call
+		std::vector<BufferBarrier> acquires;
+		auto acquired = std::remove_if(releasedRanges.begin(), releasedRanges.end(), [&](const ReleasedRange& range) {
+			if (!isComplete(range.ticket)) {
+				return false;
+			}
+			acquires.push_back({ range.dst, 0, dstAccessMask, range.offset, range.size,
+				queue.getQueueFamilyIndex(), dstQueueFamilyIndex });
+			return true;
+		});
+		releasedRanges.erase(acquired, releasedRanges.end());
+
+		if (!acquires.empty()) {
+			commandBuffer.bufferBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, acquires);
+		}
+	}
+	UploadManager::StagingSlot& UploadManager::beginSlot()
+	{
+		StagingSlot& slot = slots[currentSlot];
+		if (!slot.recording) {
+			timeline->wait(slot.ticket);
+			slot.ticket = 0;
+			slot.commandBuffer->resetCommandBuffer();
+			slot.commandBuffer->beginCommandBuffer({ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT });
+			slot.used = 0;
+			slot.recording = true;
+		}
+		return slot;
+	}
+}
@@ -8,17 +8,20 @@
 #include <Synchronous.hpp>
 #include <Window.hpp>
 #include <Descriptors.hpp>
+#include <DescriptorSetCache.hpp>
 #include <Swapchain.hpp>
 #include <Shader.hpp>
 #include <GraphicPipeline.hpp>
 #include <Framebuffer.hpp>
+#include <Upload.hpp>
+#include <FrameAllocator.hpp>
+#include <TextureLoader.hpp>
+#include <IndirectDraw.hpp>
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/fwd.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include "../third_party/stb_image.h"
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
@@ -31,7 +34,8 @@ int main()
     std::shared_ptr<basicvk::Device> device = std::make_shared<basicvk::Device>(physicalDevice);
     basicvk::Queue graphicQueue = device->getGraphicQueue();
     basicvk::Queue presentQueue = device->getPresentQueue();
-    basicvk::CommandPool commandPool(device, graphicQueue);
+    std::shared_ptr<basicvk::QueueTimeline> graphicTimeline = std::make_shared<basicvk::QueueTimeline>(device, graphicQueue);
+    basicvk::CommandPoolRing commandPoolRing(device, graphicQueue, MAX_FRAMES_IN_FLIGHT);
 
     basicvk::SwapchainCreateInfo swapchainCreateInfo{};
     swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
@@ -67,24 +71,37 @@ int main()
         {{-0.5f, 0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
     };
 
+    //both quads share the same indices, each mesh of the pool has its own vertexOffset
     const std::vector<uint16_t> indices = {
-        0, 1, 2, 2, 3, 0,
-        4, 5, 6, 6, 7, 4
+        0, 1, 2, 2, 3, 0
     };
 
     //BUFFER
 
-    basicvk::BufferOptions vertexBufferOption{};
-    vertexBufferOption.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    vertexBufferOption.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    basicvk::Buffer vertexBuffer(device, vertexBufferOption, (vertices.size() * sizeof(Vertex)));
-    vertexBuffer.mapMemory((void*)vertices.data(), vertices.size() * sizeof(Vertex));
+    //geometry goes through the transfer queue when the device has one, the frame loop takes ownership back
+    basicvk::UploadManagerOptions uploadManagerOptions{};
+    uploadManagerOptions.dstQueueFamilyIndex = graphicQueue.getQueueFamilyIndex();
+    basicvk::Queue transferQueue = device->getTransferQueue();
+    std::shared_ptr<basicvk::QueueTimeline> transferTimeline = transferQueue.getVkQueue() == graphicQueue.getVkQueue()
+        ? graphicTimeline : std::make_shared<basicvk::QueueTimeline>(device, transferQueue);
+    basicvk::UploadManager uploadManager(device, transferTimeline, uploadManagerOptions);
+
+    basicvk::MeshPoolOptions meshPoolOptions{};
+    meshPoolOptions.vertexStride = sizeof(Vertex);
+    meshPoolOptions.maxVertices = 1024;
+    meshPoolOptions.maxIndices = 4096;
+    meshPoolOptions.indexType = VK_INDEX_TYPE_UINT16;
+    basicvk::MeshPool meshPool(device, meshPoolOptions);
+    std::vector<basicvk::MeshRange> meshes = {
+        meshPool.addMesh(uploadManager, vertices.data(), 4, indices.data(), static_cast<uint32_t>(indices.size())),
+        meshPool.addMesh(uploadManager, vertices.data() + 4, 4, indices.data(), static_cast<uint32_t>(indices.size()))
+    };
+
+    basicvk::IndirectDrawListOptions indirectDrawListOptions{};
+    indirectDrawListOptions.frameCount = MAX_FRAMES_IN_FLIGHT;
+    basicvk::IndirectDrawList indirectDrawList(device, indirectDrawListOptions);
 
-    basicvk::BufferOptions indexBufferOption{};
-    indexBufferOption.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    indexBufferOption.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    basicvk::Buffer indexBuffer(device, indexBufferOption, (indices.size() * sizeof(uint16_t)));
-    indexBuffer.mapMemory((void*)indices.data(), indices.size() * sizeof(uint16_t));
+    uint64_t geometryUpload = uploadManager.submit();
 
     //GRAPHIC PIPELINE
 
@@ -115,7 +132,7 @@ int main()
     basicvk::DescriptorSetLayoutCreateInfo uboLayoutCreateInfo{};
     uboLayoutCreateInfo.binding = 0;
     uboLayoutCreateInfo.descriptorCount = 1;
-    uboLayoutCreateInfo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboLayoutCreateInfo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     uboLayoutCreateInfo.shaderStage = VK_SHADER_STAGE_VERTEX_BIT;
 
     basicvk::DescriptorSetLayoutCreateInfo imageSamplerLayoutCreateInfo{};
@@ -127,116 +144,44 @@ int main()
     basicvk::DescriptorSetLayout descriptorSetLayout(device, { uboLayoutCreateInfo, imageSamplerLayoutCreateInfo });
 
     graphicPipelineInfo.descriptorSetLayout = &descriptorSetLayout;
+    //without a render pass there is no framebuffer to rebuild with the swapchain
+    graphicPipelineInfo.dynamicRendering = device->getFeatures().dynamicRendering;
     basicvk::GraphicPipeline graphicPipeline(device, swapchain, shader, graphicPipelineInfo);
-    basicvk::Framebuffer framebuffer(device, swapchain, graphicPipeline);
-
-    std::vector<VkDescriptorPoolSize> poolSizes(2);
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    std::unique_ptr<basicvk::Framebuffer> framebuffer;
+    if (!graphicPipelineInfo.dynamicRendering) {
+        framebuffer = std::make_unique<basicvk::Framebuffer>(device, swapchain, graphicPipeline);
+    }
 
-    basicvk::DescriptorPoolCreateInfo descriptorPoolCreateInfo{};
-    descriptorPoolCreateInfo.poolSizes = poolSizes;
-    descriptorPoolCreateInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
-    basicvk::DescriptorPool descriptorPool(device, descriptorPoolCreateInfo);
+    basicvk::DescriptorSetCacheOptions descriptorSetCacheOptions{};
+    descriptorSetCacheOptions.frameCount = MAX_FRAMES_IN_FLIGHT;
+    basicvk::DescriptorSetCache descriptorSetCache(device, descriptorSetCacheOptions);
 
 
     //Prepare to render
 
     std::vector<basicvk::Semaphore> imageAvailableSemaphores;
     std::vector<basicvk::Semaphore> renderFinishedSemaphores;
-    std::vector<basicvk::Fence> inFlightFences;
-    std::vector<basicvk::Buffer> uniformBuffers;
+    std::vector<uint64_t> frameTickets(MAX_FRAMES_IN_FLIGHT, 0);
 
     VkExtent2D swapChainExtent = swapchain.getVkSwapChainExtent();
-    UniformBufferObject ubo{};
-    ubo.model = glm::rotate(glm::mat4(1.0f), 10.0f * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float)swapChainExtent.height, 0.1f, 10.0f);
-    ubo.proj[1][1] *= -1;
+
+    basicvk::FrameAllocatorOptions frameAllocatorOptions{};
+    frameAllocatorOptions.frameCount = MAX_FRAMES_IN_FLIGHT;
+    basicvk::FrameAllocator frameAllocator(device, frameAllocatorOptions);
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        basicvk::BufferOptions uniformBufferOption{};
-        uniformBufferOption.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        uniformBufferOption.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        basicvk::Buffer uniformBuffer(device, uniformBufferOption, sizeof(UniformBufferObject));
-        uniformBuffer.mapMemory((void*) &ubo, sizeof(UniformBufferObject));
-        uniformBuffers.push_back(basicvk::Buffer(uniformBuffer));
-
-        descriptorPool.allocateDescriptorSet(descriptorSetLayout);
-        commandPool.allocateCommandBuffer();
         imageAvailableSemaphores.push_back(basicvk::Semaphore(device));
         renderFinishedSemaphores.push_back(basicvk::Semaphore(device));
-        basicvk::FenceOptions fenceOptions{};
-        fenceOptions.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-        inFlightFences.push_back(basicvk::Fence(device, fenceOptions));
     }
 
     /// Creation de la texture
 
+    //decoded in the background, the frame loop binds it once its upload ticket has completed
+    basicvk::TextureLoader textureLoader(device, graphicTimeline, basicvk::TextureLoaderOptions{});
+    basicvk::TextureHandle texture = textureLoader.load("C:/Users/Arnaud/Downloads/texture.jpg");
 
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load("C:/Users/Arnaud/Downloads/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-    if (!pixels) {
-        throw std::runtime_error("failed to load texture image!");
-    }
-
-    basicvk::BufferOptions imageBufferOption{};
-    imageBufferOption.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    imageBufferOption.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    basicvk::Buffer imageBuffer(device, imageBufferOption, imageSize);
-    imageBuffer.mapMemory(pixels, imageSize);
-
-    basicvk::TextureOptions options{};
-    options.height = texHeight;
-    options.width = texWidth;
-    options.format = VK_FORMAT_R8G8B8A8_SRGB;
-    options.tiling = VK_IMAGE_TILING_OPTIMAL;
-    options.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    options.usage = (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-    options.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    options.useMimaping = true;
-    basicvk::Texture texture(device, options);
-
-    auto imageCommandBuffer = commandPool.allocateCommandBuffer();
-    
-    imageCommandBuffer->beginCommandBuffer({ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT });
-    imageCommandBuffer->transitionImageLayout(texture, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    imageCommandBuffer->CopyBufferToTexture(imageBuffer, texture);
-    imageCommandBuffer->generateMipMap(texture);
-    imageCommandBuffer->endCommandBuffer();
-    imageCommandBuffer->QueueSubmit({}, {}, nullptr);
-    graphicQueue.waitIdle();
-
-    const std::vector<std::shared_ptr<basicvk::CommandBuffer>> &commandBuffers = commandPool.getCommandBuffers();
-    const std::vector<std::shared_ptr<basicvk::DescriptorSet>> &descriptorSets = descriptorPool.getDescriptorSets();
-
-    for (size_t i = 0; i < descriptorSets.size(); i++)
-    {
-        basicvk::BufferUpdateInfo bufferUpdateInfo{};
-        bufferUpdateInfo.arrayElement = 0;
-        bufferUpdateInfo.binding = 0;
-        bufferUpdateInfo.buffer = uniformBuffers[i].getVkBuffer();
-        bufferUpdateInfo.range = sizeof(UniformBufferObject);
-        bufferUpdateInfo.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-        basicvk::TextureUpdateInfo textureToUpdate{};
-        textureToUpdate.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        textureToUpdate.imageView = texture.getVkImageView();
-        textureToUpdate.sampler = texture.getVkSampler();
-        textureToUpdate.binding = 1;
-        textureToUpdate.arrayElement = 0;
-
-        basicvk::DescriptorSetUpdateInfo descriptorSetUpdateInfo{};
-        descriptorSetUpdateInfo.bufferInfos = { bufferUpdateInfo };
-        descriptorSetUpdateInfo.textureInfos = { textureToUpdate };
-
-        descriptorSets[i]->UpdateDescriptorSet(descriptorSetUpdateInfo);
-    }
+    uploadManager.wait(geometryUpload);
 
     ///////RENDER
 
@@ -244,55 +189,73 @@ int main()
     while (!window.shouldClose()) {
         window.checkEvent();
 
-        const auto& commandBuffer = commandBuffers[currentFrame];
-        const auto& inFlightFence = inFlightFences[currentFrame];
         const auto& imageAvailableSemaphore = imageAvailableSemaphores[currentFrame];
         const auto& renderFinishedSemaphore = imageAvailableSemaphores[currentFrame];
 
-        device->waitForFences(inFlightFence, UINT64_MAX);        
-        inFlightFence.reset();
+        graphicTimeline->wait(frameTickets[currentFrame]);
+        frameAllocator.beginFrame(currentFrame);
+        commandPoolRing.beginFrame(currentFrame);
+        indirectDrawList.beginFrame(currentFrame);
+        descriptorSetCache.beginFrame(currentFrame);
+        textureLoader.update();
+
+        if (texture->hasFailed()) {
+            throw std::runtime_error(texture->getError());
+        }
 
         uint32_t imageIndex;
         swapchain.acquireNextImage(&imageIndex, &imageAvailableSemaphore, nullptr, UINT64_MAX);
 
-        commandBuffer->resetCommandBuffer();
-
-        {
-            UniformBufferObject ubo{};
-            ubo.model = glm::rotate(glm::mat4(1.0f), (float)window.getTime(), glm::vec3(0.0f, 0.0f, 1.0f));
-            ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-            ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float)swapChainExtent.height, 0.1f, 10.0f);
-            ubo.proj[1][1] *= -1;
-
-            uniformBuffers[currentFrame].mapMemory((void*)&ubo, sizeof(ubo));
+        std::shared_ptr<basicvk::CommandBuffer> commandBuffer = commandPoolRing.acquireCommandBuffer();
 
-            basicvk::BufferUpdateInfo bufferUpdateInfo{};
-            bufferUpdateInfo.arrayElement = 0;
-            bufferUpdateInfo.binding = 0;
-            bufferUpdateInfo.buffer = uniformBuffers[currentFrame].getVkBuffer();
-            bufferUpdateInfo.range = sizeof(UniformBufferObject);
-            bufferUpdateInfo.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-            basicvk::DescriptorSetUpdateInfo descriptorSetUpdateInfo{};
-            descriptorSetUpdateInfo.bufferInfos = { bufferUpdateInfo };
-            descriptorSetUpdateInfo.textureInfos = { };
-
-            descriptorSets[currentFrame]->UpdateDescriptorSet(descriptorSetUpdateInfo);
-        }
+        UniformBufferObject ubo{};
+        ubo.model = glm::rotate(glm::mat4(1.0f), (float)window.getTime(), glm::vec3(0.0f, 0.0f, 1.0f));
+        ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float)swapChainExtent.height, 0.1f, 10.0f);
+        ubo.proj[1][1] *= -1;
+        basicvk::TransientAllocation uboAllocation = frameAllocator.push(ubo);
         
         basicvk::CommandBufferUsage usage{};
         usage.usage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         commandBuffer->beginCommandBuffer(usage);
-        commandBuffer->beginRenderPass(graphicPipeline, swapchain, framebuffer, imageIndex);
+        uploadManager.acquireOwnership(*commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+        if (framebuffer) {
+            commandBuffer->beginRenderPass(graphicPipeline, swapchain, *framebuffer, imageIndex);
+        }
+        else {
+            commandBuffer->beginRendering(graphicPipeline, swapchain, imageIndex);
+        }
         commandBuffer->bindGraphicPipeline(graphicPipeline);
-        commandBuffer->bindVertexBuffer(vertexBuffer);
-        commandBuffer->bindIndexBuffer(indexBuffer, VK_INDEX_TYPE_UINT16);
-        commandBuffer->bindGraphicDescriptorSet(graphicPipeline, descriptorSets[currentFrame]);
-        commandBuffer->drawIndexed(swapchain, static_cast<uint32_t>(indices.size()));
-        commandBuffer->endRenderPass();
+        meshPool.bind(*commandBuffer);
+        if (texture->isReady()) {
+            for (const auto& mesh : meshes) {
+                indirectDrawList.add(mesh);
+            }
+            //the same resources every frame, each frame writes its set once and finds it in the cache after that
+            basicvk::DescriptorResource uboResource{};
+            uboResource.buffer = frameAllocator.getBuffer(currentFrame).getVkBuffer();
+            uboResource.range = sizeof(UniformBufferObject);
+            basicvk::DescriptorResource textureResource{};
+            textureResource.imageView = texture->getTexture().getVkImageView();
+            textureResource.sampler = texture->getTexture().getVkSampler();
+            textureResource.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            std::shared_ptr<basicvk::DescriptorSet> descriptorSet = descriptorSetCache.getDescriptorSet(descriptorSetLayout, { uboResource, textureResource });
+            commandBuffer->bindGraphicDescriptorSet(graphicPipeline, descriptorSet, { uboAllocation.offset });
+            indirectDrawList.draw(*commandBuffer, swapchain);
+        }
+        if (framebuffer) {
+            commandBuffer->endRenderPass();
+        }
+        else {
+            commandBuffer->endRendering(swapchain, imageIndex);
+        }
         commandBuffer->endCommandBuffer();
 
-        commandBuffer->QueueSubmit({ &imageAvailableSemaphore }, { &renderFinishedSemaphore }, &inFlightFence);
+        frameAllocator.flush();
+        indirectDrawList.flush();
+        device->getMemoryAllocator().flushMappedRanges();
+        frameTickets[currentFrame] = graphicTimeline->submit(*commandBuffer,
+            { { &imageAvailableSemaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT } }, { &renderFinishedSemaphore });
 
         swapchain.presentSwapchain(presentQueue, &renderFinishedSemaphore, &imageIndex);
 
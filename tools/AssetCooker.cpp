@@ -0,0 +1,327 @@
+#include <AssetPack.hpp>
+#include <TextureFile.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#define STB_IMAGE_IMPLEMENTATION
+#include "../third_party/stb_image.h"
+
+//offline tool packing images and meshes into a single memory mappable file read back by basicvk::AssetPack
+//usage : AssetCooker <output.pack> <input>...
+//images (png, jpg, tga, bmp) are cooked to R8G8B8A8_SRGB with a full mip chain,
+//ktx2/dds files keep their format and mips, obj meshes become PackedVertex + uint32 indices
+
+using namespace basicvk;
+
+struct CookedAsset {
+	AssetPackEntry entry;
+	std::vector<std::vector<char>> levels;
+	std::vector<char> vertices;
+	std::vector<char> indices;
+};
+
+static std::string getExtension(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+	return extension;
+}
+
+static std::string getAssetName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+	if (dot != std::string::npos) {
+		name = name.substr(0, dot);
+	}
+	if (name.empty() || name.size() >= ASSET_PACK_NAME_SIZE) {
+		throw std::runtime_error("asset name must be between 1 and 63 characters: " + path);
+	}
+	return name;
+}
+
+static float srgbToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float value)
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static void cookImage(const std::string& path, CookedAsset& asset)
+{
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels) {
+		throw std::runtime_error("failed to load texture image: " + path);
+	}
+
+	asset.entry.type = AssetType::Texture;
+	asset.entry.format = VK_FORMAT_R8G8B8A8_SRGB;
+	asset.entry.width = static_cast<uint32_t>(width);
+	asset.entry.height = static_cast<uint32_t>(height);
+	asset.entry.mipLevels = std::min(ASSET_PACK_MAX_LEVELS, static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1);
+
+	std::vector<float> srgbTable(256);
+	for (int i = 0; i < 256; i++) {
+		srgbTable[i] = srgbToLinear(i / 255.0f);
+	}
+
+	//box filter in linear space, alpha is averaged as is
+	std::vector<float> current(static_cast<size_t>(width) * height * 4);
+	for (size_t i = 0; i < current.size(); i++) {
+		current[i] = (i % 4 == 3) ? pixels[i] / 255.0f : srgbTable[pixels[i]];
+	}
+	stbi_image_free(pixels);
+
+	uint32_t levelWidth = asset.entry.width;
+	uint32_t levelHeight = asset.entry.height;
+	for (uint32_t level = 0; level < asset.entry.mipLevels; level++) {
+		std::vector<char> levelData(static_cast<size_t>(levelWidth) * levelHeight * 4);
+		for (size_t i = 0; i < levelData.size(); i++) {
+			float value = (i % 4 == 3) ? current[i] : linearToSrgb(current[i]);
+			levelData[i] = static_cast<char>(static_cast<uint8_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f)));
+		}
+		asset.levels.push_back(std::move(levelData));
+
+		uint32_t nextWidth = std::max(1u, levelWidth / 2);
+		uint32_t nextHeight = std::max(1u, levelHeight / 2);
+		std::vector<float> next(static_cast<size_t>(nextWidth) * nextHeight * 4);
+		for (uint32_t y = 0; y < nextHeight; y++) {
+			for (uint32_t x = 0; x < nextWidth; x++) {
+				for (uint32_t c = 0; c < 4; c++) {
+					float sum = 0.0f;
+					for (uint32_t dy = 0; dy < 2; dy++) {
+						for (uint32_t dx = 0; dx < 2; dx++) {
+							uint32_t sx = std::min(levelWidth - 1, x * 2 + dx);
+							uint32_t sy = std::min(levelHeight - 1, y * 2 + dy);
+							sum += current[(static_cast<size_t>(sy) * levelWidth + sx) * 4 + c];
+						}
+					}
+					next[(static_cast<size_t>(y) * nextWidth + x) * 4 + c] = sum * 0.25f;
+				}
+			}
+		}
+		current.swap(next);
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+	}
+}
+
+static void cookTextureFile(const std::string& path, CookedAsset& asset)
+{
+	TextureFile file(path);
+	if (file.getLevels().size() > ASSET_PACK_MAX_LEVELS) {
+		throw std::runtime_error("too many mip levels: " + path);
+	}
+
+	asset.entry.type = AssetType::Texture;
+	asset.entry.format = file.getFormat();
+	asset.entry.width = file.getWidth();
+	asset.entry.height = file.getHeight();
+	asset.entry.mipLevels = static_cast<uint32_t>(file.getLevels().size());
+	for (const auto& level : file.getLevels()) {
+		const char* begin = file.getData() + level.offset;
+		asset.levels.emplace_back(begin, begin + level.size);
+	}
+}
+
+static void cookMesh(const std::string& path, CookedAsset& asset)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open mesh: " + path);
+	}
+
+	std::vector<float> positions;
+	std::vector<float> texCoords;
+	std::vector<float> normals;
+	std::vector<PackedVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::map<std::tuple<int, int, int>, uint32_t> uniqueVertices;
+
+	//obj indices are 1 based, negative ones count back from the last element
+	auto resolve = [](int index, size_t count) {
+		return index < 0 ? static_cast<int>(count) + index : index - 1;
+	};
+
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string keyword;
+		stream >> keyword;
+		if (keyword == "v") {
+			float x, y, z;
+			stream >> x >> y >> z;
+			positions.insert(positions.end(), { x, y, z });
+		}
+		else if (keyword == "vt") {
+			float u, v;
+			stream >> u >> v;
+			texCoords.insert(texCoords.end(), { u, 1.0f - v });
+		}
+		else if (keyword == "vn") {
+			float x, y, z;
+			stream >> x >> y >> z;
+			normals.insert(normals.end(), { x, y, z });
+		}
+		else if (keyword == "f") {
+			std::vector<uint32_t> face;
+			std::string corner;
+			while (stream >> corner) {
+				int p = 0, t = 0, n = 0;
+				if (sscanf(corner.c_str(), "%d/%d/%d", &p, &t, &n) != 3 && sscanf(corner.c_str(), "%d//%d", &p, &n) != 2) {
+					sscanf(corner.c_str(), "%d/%d", &p, &t);
+				}
+				std::tuple<int, int, int> key{
+					resolve(p, positions.size() / 3),
+					t != 0 ? resolve(t, texCoords.size() / 2) : -1,
+					n != 0 ? resolve(n, normals.size() / 3) : -1 };
+
+				auto it = uniqueVertices.find(key);
+				if (it == uniqueVertices.end()) {
+					PackedVertex vertex{};
+					int pi = std::get<0>(key), ti = std::get<1>(key), ni = std::get<2>(key);
+					if (pi < 0 || static_cast<size_t>(pi) * 3 + 2 >= positions.size()) {
+						throw std::runtime_error("invalid face in mesh: " + path);
+					}
+					memcpy(vertex.position, &positions[pi * 3], sizeof(vertex.position));
+					if (ti >= 0 && static_cast<size_t>(ti) * 2 + 1 < texCoords.size()) {
+						memcpy(vertex.texCoord, &texCoords[ti * 2], sizeof(vertex.texCoord));
+					}
+					if (ni >= 0 && static_cast<size_t>(ni) * 3 + 2 < normals.size()) {
+						memcpy(vertex.normal, &normals[ni * 3], sizeof(vertex.normal));
+					}
+					it = uniqueVertices.emplace(key, static_cast<uint32_t>(vertices.size())).first;
+					vertices.push_back(vertex);
+				}
+				face.push_back(it->second);
+			}
+
+			//polygons are triangulated as a fan
+			for (size_t i = 2; i < face.size(); i++) {
+				indices.insert(indices.end(), { face[0], face[i - 1], face[i] });
+			}
+		}
+	}
+
+	asset.entry.type = AssetType::Mesh;
+	asset.entry.format = VK_FORMAT_UNDEFINED;
+	asset.entry.vertexStride = sizeof(PackedVertex);
+	asset.entry.vertexCount = static_cast<uint32_t>(vertices.size());
+	asset.entry.indexCount = static_cast<uint32_t>(indices.size());
+	asset.vertices.assign(reinterpret_cast<const char*>(vertices.data()), reinterpret_cast<const char*>(vertices.data() + vertices.size()));
+	asset.indices.assign(reinterpret_cast<const char*>(indices.data()), reinterpret_cast<const char*>(indices.data() + indices.size()));
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + 15) & ~15ull;
+}
+
+static void writePack(const std::string& path, std::vector<CookedAsset>& assets)
+{
+	//data regions first, the entry table goes last so it can be written once every offset is known
+	uint64_t offset = alignOffset(sizeof(AssetPackHeader));
+	auto place = [&offset](AssetPackRegion& region, const std::vector<char>& data) {
+		region.offset = offset;
+		region.size = data.size();
+		offset = alignOffset(offset + data.size());
+	};
+	for (auto& asset : assets) {
+		for (size_t i = 0; i < asset.levels.size(); i++) {
+			place(asset.entry.levels[i], asset.levels[i]);
+		}
+		if (asset.entry.type == AssetType::Mesh) {
+			place(asset.entry.vertices, asset.vertices);
+			place(asset.entry.indices, asset.indices);
+		}
+	}
+
+	AssetPackHeader header{};
+	header.magic = ASSET_PACK_MAGIC;
+	header.version = ASSET_PACK_VERSION;
+	header.entryCount = static_cast<uint32_t>(assets.size());
+	header.entryOffset = offset;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to create pack: " + path);
+	}
+	auto writeAt = [&file](uint64_t position, const void* data, uint64_t size) {
+		file.seekp(static_cast<std::streamoff>(position));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	};
+
+	writeAt(0, &header, sizeof(header));
+	for (auto& asset : assets) {
+		for (size_t i = 0; i < asset.levels.size(); i++) {
+			writeAt(asset.entry.levels[i].offset, asset.levels[i].data(), asset.levels[i].size());
+		}
+		if (asset.entry.type == AssetType::Mesh) {
+			writeAt(asset.entry.vertices.offset, asset.vertices.data(), asset.vertices.size());
+			writeAt(asset.entry.indices.offset, asset.indices.data(), asset.indices.size());
+		}
+	}
+	for (size_t i = 0; i < assets.size(); i++) {
+		writeAt(header.entryOffset + i * sizeof(AssetPackEntry), &assets[i].entry, sizeof(AssetPackEntry));
+	}
+	if (!file) {
+		throw std::runtime_error("failed to write pack: " + path);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		std::cerr << "usage : AssetCooker <output.pack> <input>..." << std::endl;
+		return 1;
+	}
+
+	try {
+		std::vector<CookedAsset> assets;
+		std::map<std::string, std::string> names;
+		for (int i = 2; i < argc; i++) {
+			std::string path = argv[i];
+			std::string name = getAssetName(path);
+			if (!names.emplace(name, path).second) {
+				throw std::runtime_error("two inputs are named " + name + " : " + names[name] + " and " + path);
+			}
+
+			CookedAsset asset{};
+			strncpy(asset.entry.name, name.c_str(), ASSET_PACK_NAME_SIZE - 1);
+			std::string extension = getExtension(path);
+			if (extension == "obj") {
+				cookMesh(path, asset);
+			}
+			else if (TextureFile::isTextureFile(path)) {
+				cookTextureFile(path, asset);
+			}
+			else {
+				cookImage(path, asset);
+			}
+			std::cout << "cooked " << path << " as " << name << std::endl;
+			assets.push_back(std::move(asset));
+		}
+
+		writePack(argv[1], assets);
+		std::cout << "wrote " << assets.size() << " assets to " << argv[1] << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,163 @@
+#include <VulkanBasic.hpp>
+#include <PhysicalDevice.hpp>
+#include <Device.hpp>
+#include <Buffer.hpp>
+#include <Command.hpp>
+#include <Synchronous.hpp>
+#include <MipmapGenerator.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//compares CommandBuffer::generateMipMap (one blit and two barriers per level) with the single pass
+//compute downsampler over a batch of textures, gpu time is measured with timestamp queries
+//usage : MipmapBenchmark [textureCount] [size] [downsample.spv]
+
+const uint32_t ITERATIONS = 10;
+
+static void uploadLevelZero(const basicvk::CommandBuffer& commandBuffer, const basicvk::Buffer& staging, std::vector<basicvk::Texture>& textures)
+{
+	for (auto& texture : textures) {
+		//level 0 is rewritten every iteration, the previous content can be dropped
+		texture.setVkImageLayout(VK_IMAGE_LAYOUT_UNDEFINED);
+		commandBuffer.transitionImageLayout(texture, texture.getVkFormat(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		commandBuffer.CopyBufferToTexture(staging, texture);
+	}
+}
+
+static void fullBarrier(const basicvk::CommandBuffer& commandBuffer)
+{
+	commandBuffer.memoryBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t textureCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 32;
+	uint32_t size = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 2048;
+	std::string shaderPath = argc > 3 ? argv[3] : "../../../shaders/downsample.spv";
+
+	try {
+		std::shared_ptr<basicvk::VulkanBasic> basicptr = std::make_shared<basicvk::VulkanBasic>(false);
+		std::shared_ptr<basicvk::PhysicalDevice> physicalDevice = std::make_shared<basicvk::PhysicalDevice>(basicptr, nullptr);
+		std::shared_ptr<basicvk::Device> device = std::make_shared<basicvk::Device>(physicalDevice);
+		basicvk::Queue queue = device->getGraphicQueue();
+		basicvk::CommandPool commandPool(device, queue);
+
+		basicvk::MipmapGeneratorOptions generatorOptions{};
+		generatorOptions.shaderPath = shaderPath;
+		generatorOptions.maxTexturesPerBatch = textureCount;
+		basicvk::MipmapGenerator generator(device, generatorOptions);
+
+		const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+		basicvk::TextureOptions textureOptions{};
+		textureOptions.width = size;
+		textureOptions.height = size;
+		textureOptions.format = format;
+		textureOptions.tiling = VK_IMAGE_TILING_OPTIMAL;
+		textureOptions.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		textureOptions.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		textureOptions.useMimaping = true;
+
+		std::vector<basicvk::Texture> blitTextures;
+		std::vector<basicvk::Texture> computeTextures;
+		blitTextures.reserve(textureCount);
+		computeTextures.reserve(textureCount);
+		for (uint32_t i = 0; i < textureCount; i++) {
+			textureOptions.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			textureOptions.flags = 0;
+			blitTextures.emplace_back(device, textureOptions);
+
+			textureOptions.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | basicvk::MipmapGenerator::getRequiredImageUsage();
+			textureOptions.flags = basicvk::MipmapGenerator::getRequiredImageFlags(format);
+			computeTextures.emplace_back(device, textureOptions);
+		}
+
+		uint32_t mipLevels = blitTextures[0].getMipLevels();
+		if (!generator.isSupported(format, blitTextures[0].getWidth(), blitTextures[0].getHeight(), mipLevels)) {
+			std::cerr << "single pass downsampling is not supported on this device" << std::endl;
+			return 1;
+		}
+
+		basicvk::BufferOptions stagingOptions{};
+		stagingOptions.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingOptions.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		stagingOptions.memoryUsage = basicvk::MemoryUsage::Upload;
+		basicvk::Buffer staging(device, stagingOptions, static_cast<uint64_t>(size) * size * 4);
+		basicvk::MappedSpan<uint32_t> pixels = staging.getMappedSpan<uint32_t>();
+		for (size_t i = 0; i < pixels.size(); i++) {
+			pixels[i] = static_cast<uint32_t>(i * 2654435761u);
+		}
+		staging.flush();
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 3;
+		VkQueryPool queryPool;
+		if (vkCreateQueryPool(device->getVkDevice(), &queryPoolInfo, VK_NULL_HANDLE, &queryPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create query pool");
+		}
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice->getVkPhysicalDevice(), &properties);
+
+		auto commandBuffer = commandPool.allocateCommandBuffer();
+		basicvk::Fence fence(device, basicvk::FenceOptions{});
+		double blitTotal = 0.0;
+		double computeTotal = 0.0;
+
+		for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++) {
+			commandBuffer->resetCommandBuffer();
+			commandBuffer->beginCommandBuffer({ VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT });
+			vkCmdResetQueryPool(commandBuffer->getVkCommandBuffer(), queryPool, 0, 3);
+
+			uploadLevelZero(*commandBuffer, staging, blitTextures);
+			uploadLevelZero(*commandBuffer, staging, computeTextures);
+			fullBarrier(*commandBuffer);
+			vkCmdWriteTimestamp(commandBuffer->getVkCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 0);
+
+			for (auto& texture : blitTextures) {
+				commandBuffer->generateMipMap(texture);
+			}
+			fullBarrier(*commandBuffer);
+			vkCmdWriteTimestamp(commandBuffer->getVkCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+
+			for (auto& texture : computeTextures) {
+				generator.generate(*commandBuffer, texture);
+			}
+			fullBarrier(*commandBuffer);
+			vkCmdWriteTimestamp(commandBuffer->getVkCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2);
+
+			commandBuffer->endCommandBuffer();
+			device->getMemoryAllocator().flushMappedRanges();
+			commandBuffer->QueueSubmit({}, {}, &fence);
+			fence.wait(UINT64_MAX);
+			fence.reset();
+			generator.reset();
+
+			uint64_t timestamps[3];
+			vkGetQueryPoolResults(device->getVkDevice(), queryPool, 0, 3, sizeof(timestamps), timestamps, sizeof(uint64_t),
+				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+			//the first iteration warms caches and pipelines up
+			if (iteration > 0) {
+				blitTotal += (timestamps[1] - timestamps[0]) * properties.limits.timestampPeriod * 1e-6;
+				computeTotal += (timestamps[2] - timestamps[1]) * properties.limits.timestampPeriod * 1e-6;
+			}
+		}
+
+		vkDestroyQueryPool(device->getVkDevice(), queryPool, VK_NULL_HANDLE);
+		device->waitIdle();
+
+		double measured = static_cast<double>(ITERATIONS - 1);
+		std::cout << textureCount << " textures of " << size << "x" << size << ", " << mipLevels << " levels" << std::endl;
+		std::cout << "blit chain   : " << blitTotal / measured << " ms" << std::endl;
+		std::cout << "single pass  : " << computeTotal / measured << " ms" << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}